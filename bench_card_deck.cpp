@@ -0,0 +1,63 @@
+#include "ccmix/card_deck.hpp"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+using namespace ccmix;
+
+namespace {
+
+constexpr int DATA_CARDS = 500'000;
+
+// Writes a deck of full data cards that fill memory over and over, ending in a transfer card to 0
+void write_deck(const char* path)
+{
+    std::ofstream deck{path, std::ios::binary};
+    char card[82];
+
+    deck << "LOADING ROUTINE 1\nLOADING ROUTINE 2\n";
+
+    for (int i = 0; i < DATA_CARDS; ++i)
+    {
+        const auto addr = i * 7 % (machine::memory_size - 6);
+        std::snprintf(card, sizeof(card), "DECK 7%04d", addr);
+
+        for (int w = 0; w < 7; ++w)
+        {
+            std::snprintf(card + 10 + 10 * w, 11, "%010d", i + w);
+        }
+
+        // Every other card has a negative last word
+        if (i % 2 != 0)
+        {
+            card[79] = card[79] == '0' ? '~' : 'J' + card[79] - '1';
+        }
+
+        card[80] = '\n';
+        deck.write(card, 81);
+    }
+
+    deck << "TRANS00000\n";
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    const auto path = argc > 1 ? argv[1] : "bench_card_deck.txt";
+    write_deck(path);
+
+    machine m;
+    const auto stats = load_card_deck_file(m, path, 2);
+    std::remove(path);
+
+    if (stats.status != deck_status::LOADED || stats.words != 7 * DATA_CARDS)
+    {
+        std::cerr << "loading failed at card " << stats.cards << '\n';
+        return 1;
+    }
+
+    std::cout << "cards\twords\tbytes\tseconds\tMB/s\n";
+    std::cout << stats.cards << '\t' << stats.words << '\t' << stats.bytes << '\t' << stats.seconds << '\t'
+              << stats.megabytes_per_second() << '\n';
+}
@@ -0,0 +1,58 @@
+// Compile-time benchmark: MIX programs run by the constant evaluator. See bench_constexpr.sh.
+#include "ccmix/machine.hpp"
+
+namespace ccmix {
+
+constexpr auto find_max(int n)
+{
+    machine m;
+    constexpr auto X = 1000;
+
+    for (int i = 1; i <= n; ++i)
+    {
+        m.memory[X + i] = word{(i * 7919) % 1009 - 500};
+    }
+
+    m.reg_i[0] = word{n};
+    m.memory[0] = word{AX3, 0, 1, ENT};
+    m.memory[1] = word{JMP, 4, 0, UNCOND};
+    m.memory[2] = word{CMPA, X, 3};
+    m.memory[3] = word{JMP, 6, 0, ON_GREATER_EQUAL};
+    m.memory[4] = word{AX2, 0, 3, ENT};
+    m.memory[5] = word{LDA, X, 3};
+    m.memory[6] = word{AX3, 1, 0, DEC};
+    m.memory[7] = word{J3, 2, 0, POSITIVE};
+    m.memory[8] = word{SPECIAL, 0, 0, HLT};
+    m.run();
+
+    return m.reg_a.value();
+}
+
+// Sums the (2:3) fields of an array with partial loads and stores
+constexpr auto field_sum(int n)
+{
+    machine m;
+    constexpr auto X = 1000;
+
+    for (int i = 1; i <= n; ++i)
+    {
+        m.memory[X + i] = word{i * 4097};
+    }
+
+    m.reg_i[0] = word{n};
+    m.memory[0] = word{LDA, X, 1, field_spec{4, 5}.as_opcode_mod()};
+    m.memory[1] = word{ADD, 3900};
+    m.memory[2] = word{STA, 3900};
+    m.memory[3] = word{STA, X, 1, field_spec{2, 3}.as_opcode_mod()};
+    m.memory[4] = word{AX1, 1, 0, DEC};
+    m.memory[5] = word{J1, 0, 0, POSITIVE};
+    m.memory[6] = word{SPECIAL, 0, 0, HLT};
+    m.run();
+
+    return m.memory[3900].value();
+}
+
+static_assert(find_max(2000) == 508, "");
+static_assert(field_sum(2000) == 2001000, "");
+
+}
@@ -0,0 +1,44 @@
+#!/bin/sh
+# Compile-time benchmark of the constant evaluation path. Compiles bench_constexpr.cpp as C++17
+# (no std::is_constant_evaluated) and C++20, and reports the compile time and the number of constant
+# evaluation steps needed by the largest static_assert, found by bisecting the compiler's step limit.
+#
+# Usage: ./bench_constexpr.sh [compiler...]    (default: g++ clang++)
+
+cd "$(dirname "$0")" || exit 1
+
+compilers="$*"
+[ -n "$compilers" ] || compilers="g++ clang++"
+
+compiles() {
+    "$1" -std="$2" -I. -fsyntax-only "$3" bench_constexpr.cpp 2>/dev/null
+}
+
+for cxx in $compilers; do
+    command -v "$cxx" >/dev/null || { echo "$cxx: not found"; continue; }
+
+    if "$cxx" --version | grep -q clang; then
+        limit_flag=-fconstexpr-steps
+    else
+        limit_flag=-fconstexpr-ops-limit
+    fi
+
+    for std in c++17 c++20; do
+        start=$(date +%s%N)
+        compiles "$cxx" "$std" "$limit_flag=2147483647" || { echo "$cxx $std: compilation failed"; continue; }
+        end=$(date +%s%N)
+
+        lo=0
+        hi=1048576
+        while ! compiles "$cxx" "$std" "$limit_flag=$hi"; do
+            lo=$hi
+            hi=$((hi * 2))
+        done
+        while [ $((hi - lo)) -gt $((hi / 200)) ]; do
+            mid=$(((lo + hi) / 2))
+            if compiles "$cxx" "$std" "$limit_flag=$mid"; then hi=$mid; else lo=$mid; fi
+        done
+
+        echo "$cxx $std: $(((end - start) / 1000000)) ms, ~$hi steps"
+    done
+done
@@ -0,0 +1,159 @@
+// Load generator for ccmix_server. Client threads keep a number of jobs in flight and measure the time
+// from submission until they see each job done.
+//
+// Usage: bench_server [segment name]
+// Without a name, the benchmark starts a server of its own.
+#include "ccmix/job_client.hpp"
+#include "ccmix/job_server.hpp"
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+using namespace ccmix;
+
+namespace {
+
+constexpr int CLIENTS = 2;
+constexpr int IN_FLIGHT = 16;
+constexpr int JOBS_PER_CLIENT = 20'000;
+constexpr int ARRAY = 1000;
+constexpr int ARRAY_LEN = 100;
+constexpr int INPUT = 2000;
+constexpr std::uint64_t PROGRAM_ID = 1;
+
+// Sums the array and the input
+machine program()
+{
+    machine m;
+    m.memory[0] = word{AXA, 0, 0, ENT};
+    m.memory[1] = word{AX1, ARRAY_LEN, 0, ENT};
+    m.memory[2] = word{ADD, ARRAY - 1, 1};
+    m.memory[3] = word{AX1, 1, 0, DEC};
+    m.memory[4] = word{J1, 2, 0, POSITIVE};
+    m.memory[5] = word{ADD, INPUT};
+    m.memory[6] = word{SPECIAL, 0, 0, HLT};
+
+    for (int i = 0; i < ARRAY_LEN; ++i)
+    {
+        m.memory[ARRAY + i] = word{i};
+    }
+
+    return m;
+}
+
+// Returns the latency of every job in nanoseconds, or nothing if a result is wrong
+std::vector<std::int64_t> run_client(const char* name, int client)
+{
+    job_client c{name};
+    std::vector<std::int64_t> latencies;
+    latencies.reserve(JOBS_PER_CLIENT);
+
+    auto m = program();
+    int in_flight[IN_FLIGHT];
+    int inputs[IN_FLIGHT];
+    auto submitted = 0;
+
+    const auto submit = [&](int i) {
+        inputs[i] = client * JOBS_PER_CLIENT + submitted++;
+        m.memory[INPUT] = word{inputs[i]};
+        while ((in_flight[i] = c.submit(m, PROGRAM_ID)) < 0)
+        {
+            std::this_thread::yield();
+        }
+    };
+
+    for (int i = 0; i < IN_FLIGHT; ++i)
+    {
+        submit(i);
+    }
+
+    for (int done = 0; done < JOBS_PER_CLIENT; ++done)
+    {
+        const auto i = done % IN_FLIGHT;
+        const auto job = in_flight[i];
+
+        if (!c.wait(job) || c.status(job) != JOB_DONE)
+        {
+            return {};
+        }
+
+        latencies.push_back(job_clock_ns() - c.slot(job).submit_time);
+        const auto a = word::unpack(c.result(job).registers[0]).value();
+        c.release(job);
+
+        if (a != ARRAY_LEN * (ARRAY_LEN - 1) / 2 + inputs[i])
+        {
+            return {};
+        }
+
+        if (submitted < JOBS_PER_CLIENT)
+        {
+            submit(i);
+        }
+    }
+
+    return latencies;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    const auto name = argc > 1 ? argv[1] : "/ccmix_bench";
+    std::unique_ptr<job_server> server;
+
+    if (argc <= 1)
+    {
+        const auto n_workers = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        server.reset(new job_server{name, n_workers, job_server::DEFAULT_CYCLE_BUDGET, true});
+        if (!*server)
+        {
+            std::cerr << "can't create shared memory segment " << name << '\n';
+            return 1;
+        }
+        server->start();
+    }
+
+    if (!job_client{name})
+    {
+        std::cerr << "can't connect to " << name << '\n';
+        return 1;
+    }
+
+    std::vector<std::vector<std::int64_t>> results(CLIENTS);
+    std::vector<std::thread> clients;
+
+    const auto start = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < CLIENTS; ++i)
+    {
+        clients.emplace_back([&results, name, i] { results[i] = run_client(name, i); });
+    }
+
+    for (auto& t : clients)
+    {
+        t.join();
+    }
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::vector<std::int64_t> latencies;
+    for (const auto& r : results)
+    {
+        if (r.size() != JOBS_PER_CLIENT)
+        {
+            std::cerr << "wrong or missing results\n";
+            return 1;
+        }
+        latencies.insert(latencies.end(), r.begin(), r.end());
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    const auto percentile = [&latencies](double p) {
+        return latencies[static_cast<std::size_t>(p / 100 * (latencies.size() - 1))] / 1000.0;
+    };
+
+    std::cout << "jobs\tseconds\tjobs/s\tp50 us\tp99 us\n";
+    std::cout << latencies.size() << '\t' << elapsed.count() << '\t' << latencies.size() / elapsed.count() << '\t'
+              << percentile(50) << '\t' << percentile(99) << '\n';
+}
@@ -0,0 +1,80 @@
+#include "ccmix/smp.hpp"
+#include <chrono>
+#include <iostream>
+
+using namespace ccmix;
+
+namespace {
+
+constexpr int ARRAY = 1000;
+constexpr int ARRAY_LEN = 100;
+constexpr int TOTAL = 3000;
+constexpr int TOTAL_REPS = 50'000;
+
+// Each processor sums the shared array rI1 times and adds its sum to TOTAL with a CAS loop.
+// rI6 is the processor number, used for addressing private scratch cells.
+void load_program(smp_machine& m)
+{
+    machine image;
+    image.memory[0] = word{AXA, 0, 0, ENT};
+    image.memory[1] = word{AX4, ARRAY_LEN, 0, ENT};
+    image.memory[2] = word{ADD, ARRAY - 1, 4};
+    image.memory[3] = word{AX4, 1, 0, DEC};
+    image.memory[4] = word{J4, 2, 0, POSITIVE};
+    image.memory[5] = word{AX1, 1, 0, DEC};
+    image.memory[6] = word{J1, 1, 0, POSITIVE};
+    image.memory[7] = word{STA, 3100, 6};
+    image.memory[8] = word{LDX, TOTAL};
+    image.memory[9] = word{STX, 3200, 6};
+    image.memory[10] = word{LDA, 3100, 6};
+    image.memory[11] = word{ADD, 3200, 6};
+    image.memory[12] = word{SPECIAL, TOTAL, 0, CAS};
+    image.memory[13] = word{JMP, 8, 0, ON_NOT_EQUAL};
+    image.memory[14] = word{SPECIAL, 0, 0, HLT};
+
+    for (int i = 0; i < ARRAY_LEN; ++i)
+    {
+        image.memory[ARRAY + i] = word{1};
+    }
+
+    m.load_image(image.memory);
+}
+
+}
+
+int main()
+{
+    const int max_cpus = std::max(1u, std::thread::hardware_concurrency());
+    double single = 0;
+
+    std::cout << "cpus\tseconds\tspeedup\n";
+
+    for (int n = 1; n <= max_cpus; ++n)
+    {
+        smp_machine m{n};
+        load_program(m);
+
+        for (int i = 0; i < n; ++i)
+        {
+            m.cpu(i).reg_i[0] = word{TOTAL_REPS / n + (i < TOTAL_REPS % n ? 1 : 0)};
+            m.cpu(i).reg_i[5] = word{i};
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        m.run();
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        if (m.load(TOTAL).value() != TOTAL_REPS * ARRAY_LEN)
+        {
+            std::cerr << "wrong result with " << n << " cpus: " << m.load(TOTAL).value() << '\n';
+            return 1;
+        }
+
+        if (n == 1)
+        {
+            single = elapsed.count();
+        }
+
+        std::cout << n << '\t' << elapsed.count() << '\t' << single / elapsed.count() << '\n';
+    }
+}
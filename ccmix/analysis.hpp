@@ -0,0 +1,278 @@
+#ifndef CCMIX_ANALYSIS_HPP
+#define CCMIX_ANALYSIS_HPP
+
+#include "ccmix/machine.hpp"
+#include <cstdint>
+#include <ostream>
+
+namespace ccmix {
+
+// Static analysis of a memory image: control-flow graph, basic blocks, loops and self-modification.
+//
+// Code is everything reachable from the entry point. Jumps whose target depends on an index register
+// can't be followed, and stores through an index register are assumed to be able to write anywhere.
+// A program with such a jump may execute any location, so a store anywhere in memory can modify it.
+class program_analysis
+{
+public:
+    struct successors
+    {
+        int fallthrough = -1;
+        int jump = -1;
+        bool unknown_jump = false;
+    };
+
+    constexpr program_analysis(const word (&memory)[machine::memory_size], int entry = 0)
+    {
+        if (entry < 0 || entry >= machine::memory_size)
+        {
+            return;
+        }
+
+        // Depth-first search over the control-flow graph. A node is on the stack while its successors
+        // are being visited, so an edge to a node on the stack is a back edge and its target a loop header.
+        std::int16_t stack[machine::memory_size] = {};
+        std::uint8_t visited_succs[machine::memory_size] = {};
+        int depth = 0;
+
+        stack[depth++] = static_cast<std::int16_t>(entry);
+        flags[entry] |= CODE | ON_STACK | LEADER;
+
+        while (depth > 0)
+        {
+            const int addr = stack[depth - 1];
+            const auto succ = successors_of(memory, addr);
+
+            if (visited_succs[addr] == 0)
+            {
+                visit(memory[addr], succ);
+            }
+
+            const int n = visited_succs[addr]++;
+            const int next = n == 0 ? succ.jump : n == 1 ? succ.fallthrough : -2;
+
+            if (next == -2)
+            {
+                flags[addr] &= ~ON_STACK;
+                --depth;
+                continue;
+            }
+
+            if (next < 0)
+            {
+                continue;
+            }
+
+            if ((flags[next] & ON_STACK) != 0)
+            {
+                if ((flags[next] & LOOP_HEADER) == 0)
+                {
+                    flags[next] |= LOOP_HEADER;
+                    ++loop_count;
+                }
+            }
+            else if ((flags[next] & CODE) == 0)
+            {
+                flags[next] |= CODE | ON_STACK;
+                stack[depth++] = static_cast<std::int16_t>(next);
+            }
+        }
+
+        for (int addr = 0; addr < machine::memory_size; ++addr)
+        {
+            if ((flags[addr] & (CODE | LEADER)) == (CODE | LEADER))
+            {
+                ++block_count;
+            }
+
+            if ((flags[addr] & (CODE | STORE_TARGET)) == (CODE | STORE_TARGET))
+            {
+                code_store = true;
+            }
+
+            if (unknown_jump && is_store(memory[addr]))
+            {
+                any_store = true;
+            }
+        }
+    }
+
+    static constexpr successors successors_of(const word (&memory)[machine::memory_size], int addr)
+    {
+        const auto instruction = memory[addr];
+        const auto opcode = instruction.opcode();
+        const auto mod = instruction.opcode_mod();
+
+        successors s;
+        s.fallthrough = addr + 1 < machine::memory_size ? addr + 1 : -1;
+
+        auto has_jump = false;
+        auto conditional = true;
+
+        if (opcode == SPECIAL && mod == HLT)
+        {
+            s.fallthrough = -1;
+        }
+        else if (opcode == JMP)
+        {
+            has_jump = mod == UNCOND || mod == UNCOND_SAVE_J || (mod >= ON_LESS && mod <= ON_LESS_EQUAL);
+            conditional = mod != UNCOND && mod != UNCOND_SAVE_J;
+        }
+        else if (opcode >= JA && opcode <= JX)
+        {
+            has_jump = mod <= NONPOSITIVE;
+        }
+
+        if (has_jump)
+        {
+            const auto target = instruction.address();
+
+            if (instruction.index_spec() != 0 || target < 0 || target >= machine::memory_size)
+            {
+                s.unknown_jump = true;
+            }
+            else
+            {
+                s.jump = target;
+            }
+
+            if (!conditional)
+            {
+                s.fallthrough = -1;
+            }
+        }
+
+        return s;
+    }
+
+    constexpr bool is_code(int addr) const { return (flags[addr] & CODE) != 0; }
+    constexpr bool is_block_leader(int addr) const { return (flags[addr] & (CODE | LEADER)) == (CODE | LEADER); }
+    constexpr bool is_loop_header(int addr) const { return (flags[addr] & LOOP_HEADER) != 0; }
+    constexpr bool is_store_target(int addr) const { return (flags[addr] & STORE_TARGET) != 0; }
+
+    // Code that no store in the program can modify
+    constexpr bool is_pure_code(int addr) const
+    {
+        return is_code(addr) && !is_store_target(addr) && !indexed_store && !(unknown_jump && any_store);
+    }
+
+    constexpr bool may_self_modify() const
+    {
+        return code_store || (any_store && (indexed_store || unknown_jump));
+    }
+
+    constexpr bool has_unknown_jumps() const { return unknown_jump; }
+    constexpr bool has_indexed_stores() const { return indexed_store; }
+    constexpr int n_blocks() const { return block_count; }
+    constexpr int n_loops() const { return loop_count; }
+
+    void dump(std::ostream& os, const word (&memory)[machine::memory_size]) const
+    {
+        os << "blocks: " << block_count << ", loops: " << loop_count
+           << ", self-modifying: " << (may_self_modify() ? "maybe" : "no")
+           << (unknown_jump ? ", unknown jump targets" : "")
+           << (indexed_store ? ", indexed stores" : "") << '\n';
+
+        for (int addr = 0; addr < machine::memory_size; ++addr)
+        {
+            if (!is_block_leader(addr))
+            {
+                continue;
+            }
+
+            auto last = addr;
+            while (successors_of(memory, last).fallthrough == last + 1 && !is_block_leader(last + 1))
+            {
+                ++last;
+            }
+
+            const auto succ = successors_of(memory, last);
+            os << (is_loop_header(addr) ? "loop " : "block ") << addr << '-' << last << " ->";
+            if (succ.jump >= 0)
+            {
+                os << ' ' << succ.jump;
+            }
+            if (succ.fallthrough >= 0)
+            {
+                os << ' ' << succ.fallthrough;
+            }
+            if (succ.unknown_jump)
+            {
+                os << " ?";
+            }
+            for (auto a = addr; a <= last; ++a)
+            {
+                if (!is_pure_code(a))
+                {
+                    os << " (impure " << a << ')';
+                }
+            }
+            os << '\n';
+        }
+    }
+
+private:
+    enum : std::uint8_t
+    {
+        CODE = 1,
+        LEADER = 2,
+        LOOP_HEADER = 4,
+        STORE_TARGET = 8,
+        ON_STACK = 16
+    };
+
+    static constexpr bool is_store(word instruction)
+    {
+        const auto opcode = instruction.opcode();
+        const auto mod = instruction.opcode_mod();
+        return (opcode >= STA && opcode <= STZ) || (opcode == SPECIAL && (mod == XCH || mod == CAS));
+    }
+
+    constexpr void visit(word instruction, const successors& succ)
+    {
+        if (is_store(instruction))
+        {
+            any_store = true;
+
+            const auto target = instruction.address();
+            if (instruction.index_spec() != 0)
+            {
+                indexed_store = true;
+            }
+            else if (target >= 0 && target < machine::memory_size)
+            {
+                flags[target] |= STORE_TARGET;
+            }
+        }
+
+        if (succ.unknown_jump)
+        {
+            unknown_jump = true;
+        }
+
+        // A branch starts new blocks at both of its successors
+        if (succ.jump >= 0 || succ.unknown_jump || succ.fallthrough < 0)
+        {
+            if (succ.jump >= 0)
+            {
+                flags[succ.jump] |= LEADER;
+            }
+            if (succ.fallthrough >= 0)
+            {
+                flags[succ.fallthrough] |= LEADER;
+            }
+        }
+    }
+
+    std::uint8_t flags[machine::memory_size] = {};
+    int block_count = 0;
+    int loop_count = 0;
+    bool any_store = false;
+    bool indexed_store = false;
+    bool code_store = false;
+    bool unknown_jump = false;
+};
+
+}
+
+#endif
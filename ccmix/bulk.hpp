@@ -0,0 +1,67 @@
+#ifndef CCMIX_BULK_HPP
+#define CCMIX_BULK_HPP
+
+#include "ccmix/word.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace ccmix {
+
+// Conversions between ranges of words and host integers, e.g. for filling machine memory with data.
+//
+// The loops have no branches or calls in their bodies and work in constant expressions too. Values that
+// don't fit in a word are truncated the same way as in word{int}.
+//
+// Only the import vectorizes (partially) with GCC 12. The exports stay scalar, as a word is 6 bytes and
+// the vectorizer doesn't support interleaved byte loads with that stride. Splitting an export into one
+// vectorized pass per byte turned out 2.5 times slower than the scalar loop.
+
+template <class Int>
+constexpr void import_words(const Int* src, std::size_t n, word* dest)
+{
+    static_assert(std::is_integral<Int>::value && std::is_signed<Int>::value, "signed integer type required");
+
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        const auto v = static_cast<std::int64_t>(src[i]);
+        const auto neg = v < 0;
+        const auto abs = static_cast<std::uint64_t>(neg ? -v : v);
+        dest[i] = word{static_cast<unsigned int>(abs), neg};
+    }
+}
+
+template <class Int>
+constexpr void export_words(const word* src, std::size_t n, Int* dest)
+{
+    static_assert(std::is_integral<Int>::value && std::is_signed<Int>::value, "signed integer type required");
+
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        dest[i] = src[i].value();
+    }
+}
+
+// Same as exporting src[i].field(f).value() for every word
+template <class Int>
+constexpr void export_field(const word* src, std::size_t n, field_spec f, Int* dest)
+{
+    static_assert(std::is_integral<Int>::value && std::is_signed<Int>::value, "signed integer type required");
+
+    constexpr unsigned int byte_bits = word::n_bits() / 5;
+    const auto include_sign = f.left() == 0;
+    const auto first = include_sign ? 1 : f.left();
+    const auto n_bytes = f.right() + 1 > first ? f.right() + 1 - first : 0;
+    const auto shift = byte_bits * (5 - f.right());
+    const auto mask = (1u << (byte_bits * n_bytes)) - 1;
+
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        const auto abs = static_cast<Int>((src[i].abs_value() >> shift) & mask);
+        dest[i] = include_sign && src[i].negative() ? -abs : abs;
+    }
+}
+
+}
+
+#endif
@@ -0,0 +1,326 @@
+#ifndef CCMIX_CARD_DECK_HPP
+#define CCMIX_CARD_DECK_HPP
+
+#include "ccmix/machine.hpp"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+
+namespace ccmix {
+
+enum class deck_status
+{
+    LOADING,
+    LOADED,
+    BAD_CARD,
+    BAD_ADDRESS,
+    NO_TRANSFER_CARD,
+    IO_ERROR
+};
+
+// Decodes a card deck in the format read by the loading routine of TAOCP section 1.3.1 (exercise 26)
+// straight into machine memory. The deck can be given in chunks of any size, as the decoder keeps only
+// the current card.
+//
+// Cards are lines of at most 80 columns, and missing columns at the end of a line are blank. The loader
+// cards at the start of the deck are skipped. Every card after them is either
+//  - a data card: column 6 has the number of words on the card (1-7) and columns 7-10 the location of the
+//    first one. The words follow as ten decimal digits in columns 11-20, 21-30 and so on. The last digit
+//    of a negative word is overpunched, which is written as ~ for 0 and J-R for 1-9. Columns 1-5 are ignored.
+//  - the transfer card: TRANS0 in columns 1-6 and the location of the first instruction in columns 7-10,
+//    which becomes pc. Loading ends at the transfer card.
+class card_decoder
+{
+public:
+    static constexpr int COLUMNS = 80;
+    static constexpr int MAX_WORDS = 7;
+
+    constexpr explicit card_decoder(machine& m, int loader_cards = 2) : m(&m), loader_cards(loader_cards) {}
+
+    // Returns false when loading has ended, at the transfer card or at an error
+    constexpr bool feed(const char* data, std::size_t n)
+    {
+        std::size_t i = 0;
+
+        for (; i < n && state == deck_status::LOADING; ++i)
+        {
+            const auto c = data[i];
+
+            if (c == '\n')
+            {
+                end_card();
+            }
+            else if (c != '\r')
+            {
+                if (column < COLUMNS)
+                {
+                    card[column] = c;
+                }
+                ++column;
+            }
+        }
+
+        n_bytes += i;
+        return state == deck_status::LOADING;
+    }
+
+    // Decodes the last card if it doesn't end in a newline. A deck without a transfer card is an error.
+    constexpr deck_status finish()
+    {
+        if (state == deck_status::LOADING && column > 0)
+        {
+            end_card();
+        }
+
+        if (state == deck_status::LOADING)
+        {
+            state = deck_status::NO_TRANSFER_CARD;
+        }
+
+        return state;
+    }
+
+    constexpr deck_status status() const
+    {
+        return state;
+    }
+
+    // Cards read, including the loader cards. After an error, this is the number of the bad card.
+    constexpr int cards() const
+    {
+        return n_cards;
+    }
+
+    constexpr int words() const
+    {
+        return n_words;
+    }
+
+    constexpr std::size_t bytes() const
+    {
+        return n_bytes;
+    }
+
+private:
+    constexpr void end_card()
+    {
+        const auto length = column;
+        column = 0;
+
+        // Blank lines aren't cards
+        if (length == 0)
+        {
+            return;
+        }
+
+        ++n_cards;
+
+        if (length > COLUMNS)
+        {
+            state = deck_status::BAD_CARD;
+            return;
+        }
+
+        if (n_cards <= loader_cards)
+        {
+            return;
+        }
+
+        for (auto i = length; i < COLUMNS; ++i)
+        {
+            card[i] = ' ';
+        }
+
+        const auto addr = number(6, 4);
+
+        if (is_transfer_card())
+        {
+            if (addr < 0 || addr >= machine::memory_size)
+            {
+                state = addr < 0 ? deck_status::BAD_CARD : deck_status::BAD_ADDRESS;
+                return;
+            }
+
+            m->pc = addr;
+            state = deck_status::LOADED;
+            return;
+        }
+
+        const auto n = digit(card[5]);
+
+        if (n < 1 || n > MAX_WORDS || addr < 0)
+        {
+            state = deck_status::BAD_CARD;
+            return;
+        }
+
+        if (addr + n > machine::memory_size)
+        {
+            state = deck_status::BAD_ADDRESS;
+            return;
+        }
+
+        // A bad card leaves memory untouched
+        word words[MAX_WORDS];
+
+        for (auto i = 0; i < n; ++i)
+        {
+            if (!decode_word(10 + 10 * i, words[i]))
+            {
+                state = deck_status::BAD_CARD;
+                return;
+            }
+        }
+
+        for (auto i = 0; i < n; ++i)
+        {
+            m->memory[addr + i] = words[i];
+        }
+
+        n_words += n;
+    }
+
+    constexpr bool is_transfer_card() const
+    {
+        const char transfer[] = "TRANS0";
+
+        for (auto i = 0; i < 6; ++i)
+        {
+            if (card[i] != transfer[i])
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    static constexpr int digit(char c)
+    {
+        return c >= '0' && c <= '9' ? c - '0' : -1;
+    }
+
+    // The decimal number in columns first + 1 to first + n, or -1 if they aren't all digits
+    constexpr int number(int first, int n) const
+    {
+        auto value = 0;
+
+        for (auto i = first; i < first + n; ++i)
+        {
+            const auto d = digit(card[i]);
+            if (d < 0)
+            {
+                return -1;
+            }
+            value = 10 * value + d;
+        }
+
+        return value;
+    }
+
+    // Like NUM, keeps the value modulo the word size
+    constexpr bool decode_word(int first, word& w) const
+    {
+        std::uint64_t value = 0;
+
+        for (auto i = first; i < first + 9; ++i)
+        {
+            const auto d = digit(card[i]);
+            if (d < 0)
+            {
+                return false;
+            }
+            value = 10 * value + d;
+        }
+
+        const auto last = card[first + 9];
+        auto d = digit(last);
+        const auto negative = d < 0;
+
+        if (last == '~')
+        {
+            d = 0;
+        }
+        else if (last >= 'J' && last <= 'R')
+        {
+            d = last - 'J' + 1;
+        }
+        else if (d < 0)
+        {
+            return false;
+        }
+
+        value = 10 * value + d;
+        w = word{static_cast<unsigned int>(value & ((std::uint64_t{1} << word::n_bits()) - 1)), negative};
+        return true;
+    }
+
+    machine* m;
+    int loader_cards;
+    deck_status state = deck_status::LOADING;
+    char card[COLUMNS] = {};
+    int column = 0;
+    int n_cards = 0;
+    int n_words = 0;
+    std::size_t n_bytes = 0;
+};
+
+// Loads a card deck from a string
+constexpr deck_status load_card_deck(machine& m, const char* deck, std::size_t length, int loader_cards = 2)
+{
+    card_decoder decoder{m, loader_cards};
+    decoder.feed(deck, length);
+    return decoder.finish();
+}
+
+struct deck_load_stats
+{
+    deck_status status = deck_status::LOADING;
+    int cards = 0;
+    int words = 0;
+    std::size_t bytes = 0;
+    double seconds = 0;
+
+    double megabytes_per_second() const
+    {
+        return seconds > 0 ? bytes / seconds / 1e6 : 0;
+    }
+};
+
+constexpr std::size_t CARD_DECK_CHUNK_SIZE = 64 * 1024;
+
+// Loads a card deck file, reading it in chunks of CARD_DECK_CHUNK_SIZE bytes. Reading stops at the transfer card.
+inline deck_load_stats load_card_deck_file(machine& m, const char* path, int loader_cards = 2)
+{
+    const auto start = std::chrono::steady_clock::now();
+    deck_load_stats stats;
+    std::ifstream file{path, std::ios::binary};
+
+    if (!file)
+    {
+        stats.status = deck_status::IO_ERROR;
+        return stats;
+    }
+
+    card_decoder decoder{m, loader_cards};
+    char chunk[CARD_DECK_CHUNK_SIZE];
+    auto more = true;
+
+    while (more && file)
+    {
+        file.read(chunk, CARD_DECK_CHUNK_SIZE);
+        more = decoder.feed(chunk, static_cast<std::size_t>(file.gcount()));
+    }
+
+    stats.status = file.bad() ? deck_status::IO_ERROR : decoder.finish();
+    stats.cards = decoder.cards();
+    stats.words = decoder.words();
+    stats.bytes = decoder.bytes();
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
+
+}
+
+#endif
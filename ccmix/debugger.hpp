@@ -0,0 +1,149 @@
+#ifndef CCMIX_DEBUGGER_HPP
+#define CCMIX_DEBUGGER_HPP
+
+#include "ccmix/machine.hpp"
+#include <cstdint>
+
+namespace ccmix {
+
+enum class stop_reason
+{
+    HALTED,
+    BREAKPOINT,
+    WATCHPOINT
+};
+
+enum watch_access
+{
+    WATCH_READ = 1,
+    WATCH_WRITE = 2,
+    WATCH_READ_WRITE = 3
+};
+
+struct stop_event
+{
+    stop_reason reason = stop_reason::HALTED;
+
+    // Location of the breakpoint, or of the instruction that triggered the watchpoint
+    int pc = 0;
+
+    // Watched memory location and the kind of access that was made to it
+    int address = 0;
+    watch_access access = WATCH_READ;
+};
+
+// Address breakpoints and memory watchpoints for machine::run(debugger&).
+//
+// A breakpoint stops execution before the instruction at its address, and the next run resumes from it
+// without stopping there again. A watchpoint stops execution after
+// an instruction reads or writes a field that overlaps the watched field of the watched location.
+class debugger
+{
+public:
+    static constexpr bool enabled = true;
+
+    constexpr void set_breakpoint(int addr)
+    {
+        flags[addr] |= BREAKPOINT;
+    }
+
+    constexpr void clear_breakpoint(int addr)
+    {
+        flags[addr] &= ~BREAKPOINT;
+    }
+
+    constexpr void watch(int addr, watch_access access, field_spec f = field_spec::all())
+    {
+        flags[addr] = (flags[addr] & BREAKPOINT) | access;
+        watched_fields[addr] = static_cast<std::uint8_t>(f.as_opcode_mod());
+    }
+
+    constexpr void unwatch(int addr)
+    {
+        flags[addr] &= BREAKPOINT;
+    }
+
+    constexpr void start()
+    {
+        stop = stop_event{};
+        has_stopped = false;
+    }
+
+    constexpr stop_event last_stop() const
+    {
+        return stop;
+    }
+
+    constexpr bool break_at(int pc, std::uint64_t)
+    {
+        const auto resuming = pc == resume_pc;
+        resume_pc = -1;
+
+        if (resuming || (flags[pc] & BREAKPOINT) == 0)
+        {
+            return false;
+        }
+
+        stop.reason = stop_reason::BREAKPOINT;
+        stop.pc = pc;
+        stop.address = pc;
+        has_stopped = true;
+        resume_pc = pc;
+        return true;
+    }
+
+    constexpr void on_read(int addr, field_spec f, int pc)
+    {
+        check(addr, f, WATCH_READ, pc);
+    }
+
+    constexpr void on_write(int addr, field_spec f, int pc)
+    {
+        check(addr, f, WATCH_WRITE, pc);
+    }
+
+    constexpr bool stopped() const
+    {
+        return has_stopped;
+    }
+
+private:
+    enum : std::uint8_t
+    {
+        BREAKPOINT = 4
+    };
+
+    constexpr void check(int addr, field_spec f, watch_access access, int pc)
+    {
+        if ((flags[addr] & access) == 0 || has_stopped)
+        {
+            return;
+        }
+
+        const field_spec watched{watched_fields[addr]};
+        const auto left = f.left() > watched.left() ? f.left() : watched.left();
+        const auto right = f.right() < watched.right() ? f.right() : watched.right();
+        if (left > right)
+        {
+            return;
+        }
+
+        stop.reason = stop_reason::WATCHPOINT;
+        stop.pc = pc;
+        stop.address = addr;
+        stop.access = access;
+        has_stopped = true;
+    }
+
+    std::uint8_t flags[machine::memory_size] = {};
+    std::uint8_t watched_fields[machine::memory_size] = {};
+    stop_event stop;
+    bool has_stopped = false;
+
+    // Address of the breakpoint that stopped the last run, skipped once by the next run
+    int resume_pc = -1;
+};
+
+}
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef CCMIX_JOB_CLIENT_HPP
+#define CCMIX_JOB_CLIENT_HPP
+
+#include "ccmix/job_queue.hpp"
+#include <thread>
+
+namespace ccmix {
+
+// Submits jobs to a running ccmix_server through its shared memory segment. A job is identified by its
+// slot, which holds the final state after the job is done, until the job is released.
+//
+// Several threads can use one client, as long as each job is used by only one of them.
+class job_client
+{
+public:
+    explicit job_client(const char* name) : segment(mapped_job_segment::open(name)) {}
+
+    explicit operator bool() const
+    {
+        return static_cast<bool>(segment);
+    }
+
+    // Returns the slot of the job, or -1 if every slot is taken.
+    // Jobs with the same program id should have mostly the same memory, to benefit from batching.
+    int submit(const machine& m, std::uint64_t program_id)
+    {
+        std::uint32_t job = 0;
+        if (!segment->free_slots.pop(job))
+        {
+            return -1;
+        }
+
+        auto& slot = segment->slots[job];
+        slot.program_id = program_id;
+        pack_state(m, slot.state);
+        slot.status.store(JOB_QUEUED, std::memory_order_relaxed);
+        slot.submit_time = job_clock_ns();
+
+        // Can't fail, as the ring has a cell for every slot
+        segment->queued_jobs.push(job);
+        return static_cast<int>(job);
+    }
+
+    // JOB_DONE if the job halted, see job_status for the others
+    job_status status(int job) const
+    {
+        return static_cast<job_status>(segment->slots[job].status.load(std::memory_order_acquire));
+    }
+
+    bool done(int job) const
+    {
+        return job_finished(status(job));
+    }
+
+    // Returns false if the server stopped before taking the job
+    bool wait(int job) const
+    {
+        while (!done(job))
+        {
+            if (segment->stopping.load(std::memory_order_acquire) != 0)
+            {
+                return done(job);
+            }
+            std::this_thread::yield();
+        }
+        return true;
+    }
+
+    // The final state of a finished job, read in place in the shared segment
+    const packed_state& result(int job) const
+    {
+        return segment->slots[job].state;
+    }
+
+    const job_slot& slot(int job) const
+    {
+        return segment->slots[job];
+    }
+
+    void release(int job)
+    {
+        segment->slots[job].status.store(JOB_FREE, std::memory_order_relaxed);
+        segment->free_slots.push(static_cast<std::uint32_t>(job));
+    }
+
+    // The server's metrics
+    const job_segment& server() const
+    {
+        return *segment;
+    }
+
+private:
+    mapped_job_segment segment;
+};
+
+}
+
+#endif
@@ -0,0 +1,378 @@
+#ifndef CCMIX_JOB_QUEUE_HPP
+#define CCMIX_JOB_QUEUE_HPP
+
+#include "ccmix/packed_state.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fcntl.h>
+#include <new>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+
+namespace ccmix {
+
+// The shared memory segment of ccmix_server, mapped by the server and by its clients.
+//
+// A job occupies one of the slots from submission until the client releases it. The client takes a slot
+// index from free_slots, packs the machine state into the slot and pushes the index to queued_jobs.
+// A worker pops it, runs the machine and writes the final state back into the same slot, where the client
+// reads it after seeing a finished status. Everything in the segment is address free, as processes map it at
+// different addresses.
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2, "shared memory needs lock-free atomics");
+
+constexpr std::size_t JOB_SLOTS = 256;
+constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+// Nanoseconds of std::chrono::steady_clock, which is the same clock in every process on a host
+inline std::int64_t job_clock_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Bounded lock-free multi-producer multi-consumer queue of slot indices (Vyukov). Each cell has a sequence
+// number telling whether it's free for the push or the pop at a given position.
+class index_ring
+{
+public:
+    index_ring()
+    {
+        for (std::size_t i = 0; i < JOB_SLOTS; ++i)
+        {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // Returns false if the ring is full
+    bool push(std::uint32_t value)
+    {
+        auto pos = enqueue_pos.load(std::memory_order_relaxed);
+
+        for (;;)
+        {
+            auto& cell = cells[pos % JOB_SLOTS];
+            const auto seq = cell.sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::int64_t>(seq) - static_cast<std::int64_t>(pos);
+
+            if (diff == 0)
+            {
+                if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    cell.value = value;
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Returns false if the ring is empty
+    bool pop(std::uint32_t& value)
+    {
+        auto pos = dequeue_pos.load(std::memory_order_relaxed);
+
+        for (;;)
+        {
+            auto& cell = cells[pos % JOB_SLOTS];
+            const auto seq = cell.sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::int64_t>(seq) - static_cast<std::int64_t>(pos + 1);
+
+            if (diff == 0)
+            {
+                if (dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    value = cell.value;
+                    cell.sequence.store(pos + JOB_SLOTS, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = dequeue_pos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Approximate while other threads push and pop
+    std::size_t size() const
+    {
+        const auto pushed = enqueue_pos.load(std::memory_order_relaxed);
+        const auto popped = dequeue_pos.load(std::memory_order_relaxed);
+        return pushed > popped ? static_cast<std::size_t>(pushed - popped) : 0;
+    }
+
+private:
+    struct alignas(CACHE_LINE_SIZE) cell
+    {
+        std::atomic<std::uint64_t> sequence;
+        std::uint32_t value;
+    };
+
+    alignas(CACHE_LINE_SIZE) std::atomic<std::uint64_t> enqueue_pos{0};
+    alignas(CACHE_LINE_SIZE) std::atomic<std::uint64_t> dequeue_pos{0};
+    cell cells[JOB_SLOTS];
+};
+
+enum job_status : std::uint32_t
+{
+    JOB_FREE,
+    JOB_QUEUED,
+    JOB_RUNNING,
+
+    // Finished: halted, stopped by the sandbox (see sandbox_result), or cancelled by the server stopping
+    JOB_DONE,
+    JOB_FAULT,
+    JOB_OVER_BUDGET,
+    JOB_CANCELLED
+};
+
+constexpr bool job_finished(std::uint32_t status)
+{
+    return status >= JOB_DONE;
+}
+
+struct alignas(CACHE_LINE_SIZE) job_slot
+{
+    std::atomic<std::uint32_t> status{JOB_FREE};
+
+    // Chosen by the client. Jobs with the same id are assumed to have mostly the same memory.
+    std::uint64_t program_id = 0;
+
+    // job_clock_ns() at submission and at completion
+    std::int64_t submit_time = 0;
+    std::int64_t finish_time = 0;
+
+    // The initial state, replaced by the final state when the job is done
+    packed_state state;
+};
+
+// Latencies in buckets a quarter of a power of two nanoseconds wide, so percentiles are within 25%
+class latency_histogram
+{
+public:
+    static constexpr int N_BUCKETS = 4 * 64;
+
+    void add(std::int64_t ns)
+    {
+        buckets[bucket(ns < 1 ? 1 : static_cast<std::uint64_t>(ns))].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::uint64_t count() const
+    {
+        std::uint64_t n = 0;
+        for (const auto& b : buckets)
+        {
+            n += b.load(std::memory_order_relaxed);
+        }
+        return n;
+    }
+
+    // Upper bound of the bucket of the p'th percentile, or 0 if there are no samples
+    std::uint64_t percentile(double p) const
+    {
+        const auto n = count();
+        const auto rank = static_cast<std::uint64_t>(p / 100 * n);
+        std::uint64_t seen = 0;
+
+        for (int i = 0; i < N_BUCKETS; ++i)
+        {
+            seen += buckets[i].load(std::memory_order_relaxed);
+            if (n > 0 && seen > rank)
+            {
+                return upper_bound(i);
+            }
+        }
+
+        return 0;
+    }
+
+private:
+    static int bucket(std::uint64_t ns)
+    {
+        auto log2 = 0;
+        for (auto v = ns; v > 1; v >>= 1, ++log2) {}
+        const auto quarter = log2 >= 2 ? static_cast<int>(ns >> (log2 - 2)) & 3 : 0;
+        return 4 * log2 + quarter;
+    }
+
+    static std::uint64_t upper_bound(int bucket)
+    {
+        const auto log2 = bucket / 4;
+        const auto quarter = bucket % 4;
+        return log2 >= 2 ? (static_cast<std::uint64_t>(5 + quarter) << (log2 - 2)) - 1 : (std::uint64_t{2} << log2) - 1;
+    }
+
+    std::atomic<std::uint64_t> buckets[N_BUCKETS] = {};
+};
+
+struct job_segment
+{
+    static constexpr std::uint64_t MAGIC = 0x43434D49584A4F42; // "CCMIXJOB"
+    static constexpr std::uint32_t VERSION = 2;
+
+    std::uint64_t magic = MAGIC;
+    std::uint32_t version = VERSION;
+    std::uint32_t n_slots = JOB_SLOTS;
+
+    // Set when the server shuts down
+    std::atomic<std::uint32_t> stopping{0};
+
+    // Cycles a job may take before it's stopped with status OVER_BUDGET
+    std::uint64_t cycle_budget = 0;
+
+    // Metrics, updated by the server. Completed jobs include the failed ones.
+    std::atomic<std::uint64_t> completed{0};
+    std::atomic<std::uint64_t> failed{0};
+    std::atomic<std::uint64_t> batches{0};
+    std::atomic<std::uint64_t> max_queue_depth{0};
+    latency_histogram latency;
+
+    index_ring free_slots;
+    index_ring queued_jobs;
+    job_slot slots[JOB_SLOTS];
+
+    job_segment()
+    {
+        for (std::uint32_t i = 0; i < JOB_SLOTS; ++i)
+        {
+            free_slots.push(i);
+        }
+    }
+
+    bool compatible() const
+    {
+        return magic == MAGIC && version == VERSION && n_slots == JOB_SLOTS;
+    }
+};
+
+// A job_segment in POSIX shared memory. The creator owns the segment and removes it when done.
+class mapped_job_segment
+{
+public:
+    // Fails if a segment with the name exists, as another server may be using it, unless replace is set.
+    // Check the result with operator bool.
+    static mapped_job_segment create(const char* name, bool replace = false)
+    {
+        if (replace)
+        {
+            shm_unlink(name);
+        }
+
+        const auto fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0)
+        {
+            return mapped_job_segment{};
+        }
+
+        void* addr = ftruncate(fd, sizeof(job_segment)) == 0 ? map(fd) : nullptr;
+        close(fd);
+
+        if (addr == nullptr)
+        {
+            shm_unlink(name);
+            return mapped_job_segment{};
+        }
+
+        return mapped_job_segment{new (addr) job_segment{}, name};
+    }
+
+    static mapped_job_segment open(const char* name)
+    {
+        const auto fd = shm_open(name, O_RDWR, 0);
+        if (fd < 0)
+        {
+            return mapped_job_segment{};
+        }
+
+        struct stat info;
+        void* addr = fstat(fd, &info) == 0 && info.st_size >= static_cast<off_t>(sizeof(job_segment)) ? map(fd) : nullptr;
+        close(fd);
+
+        mapped_job_segment mapping{static_cast<job_segment*>(addr), nullptr};
+        if (mapping && !mapping->compatible())
+        {
+            return mapped_job_segment{};
+        }
+
+        return mapping;
+    }
+
+    mapped_job_segment() = default;
+
+    mapped_job_segment(mapped_job_segment&& other) noexcept : segment(other.segment), owned_name(std::move(other.owned_name))
+    {
+        other.segment = nullptr;
+        other.owned_name.clear();
+    }
+
+    mapped_job_segment& operator=(mapped_job_segment&& other) noexcept
+    {
+        std::swap(segment, other.segment);
+        std::swap(owned_name, other.owned_name);
+        return *this;
+    }
+
+    ~mapped_job_segment()
+    {
+        if (segment != nullptr)
+        {
+            munmap(segment, sizeof(job_segment));
+        }
+
+        if (!owned_name.empty())
+        {
+            shm_unlink(owned_name.c_str());
+        }
+    }
+
+    explicit operator bool() const
+    {
+        return segment != nullptr;
+    }
+
+    job_segment* operator->() const
+    {
+        return segment;
+    }
+
+    job_segment& operator*() const
+    {
+        return *segment;
+    }
+
+private:
+    mapped_job_segment(job_segment* segment, const char* owned_name)
+        : segment(segment), owned_name(owned_name != nullptr ? owned_name : "")
+    {
+    }
+
+    static void* map(int fd)
+    {
+        void* addr = mmap(nullptr, sizeof(job_segment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        return addr == MAP_FAILED ? nullptr : addr;
+    }
+
+    job_segment* segment = nullptr;
+    std::string owned_name;
+};
+
+}
+
+#endif
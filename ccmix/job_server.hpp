@@ -0,0 +1,221 @@
+#ifndef CCMIX_JOB_SERVER_HPP
+#define CCMIX_JOB_SERVER_HPP
+
+#include "ccmix/job_queue.hpp"
+#include "ccmix/sandbox.hpp"
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace ccmix {
+
+// Runs the jobs queued in a job_segment on a pool of worker threads, see ccmix_server.
+//
+// A worker takes a batch of jobs at a time and runs the ones with the same program id back to back.
+// It keeps the memory of its last job unpacked, so that for a job of the same program it only has to
+// unpack the words that differ. Jobs run in a sandbox with a budget of cycles, so that a client can't make
+// the server access memory outside the job or keep a worker busy indefinitely.
+class job_server
+{
+public:
+    static constexpr int MAX_BATCH = 16;
+    static constexpr std::uint64_t DEFAULT_CYCLE_BUDGET = 1'000'000'000;
+
+    // See mapped_job_segment::create() for replace
+    job_server(const char* name, int n_workers, std::uint64_t cycle_budget = DEFAULT_CYCLE_BUDGET, bool replace = false)
+        : segment(mapped_job_segment::create(name, replace)), n_workers(n_workers)
+    {
+        if (segment)
+        {
+            segment->cycle_budget = cycle_budget;
+        }
+    }
+
+    ~job_server()
+    {
+        stop();
+    }
+
+    explicit operator bool() const
+    {
+        return static_cast<bool>(segment);
+    }
+
+    void start()
+    {
+        for (int i = 0; i < n_workers; ++i)
+        {
+            workers.emplace_back([this] {
+                // Two machines are too large to keep on every thread's stack
+                std::unique_ptr<worker> w{new worker{*segment, n_workers}};
+                w->run();
+            });
+        }
+    }
+
+    // Cancels the jobs that the workers have taken, and leaves the rest of the queue
+    void stop()
+    {
+        if (segment)
+        {
+            segment->stopping.store(1, std::memory_order_release);
+        }
+
+        for (auto& t : workers)
+        {
+            t.join();
+        }
+        workers.clear();
+    }
+
+    const job_segment& metrics() const
+    {
+        return *segment;
+    }
+
+private:
+    class worker
+    {
+    public:
+        worker(job_segment& segment, int n_workers) : segment(segment), n_workers(n_workers) {}
+
+        void run()
+        {
+            std::uint32_t batch[MAX_BATCH];
+            auto idle = 0;
+
+            while (segment.stopping.load(std::memory_order_acquire) == 0)
+            {
+                // A fair share of the queue, so that a short queue doesn't go to a single worker
+                const auto depth = segment.queued_jobs.size();
+                const auto limit = std::min<std::size_t>(MAX_BATCH, 1 + depth / n_workers);
+                record_depth(depth);
+
+                // Clients can write anything into the segment, so indices are checked and a job is run only
+                // if it's still queued
+                std::size_t n = 0;
+                for (std::uint32_t job = 0; n < limit && segment.queued_jobs.pop(job);)
+                {
+                    if (job < JOB_SLOTS && claim(segment.slots[job]))
+                    {
+                        batch[n++] = job;
+                    }
+                }
+
+                if (n == 0)
+                {
+                    back_off(idle++);
+                    continue;
+                }
+                idle = 0;
+
+                std::stable_sort(batch, batch + n, [this](std::uint32_t a, std::uint32_t b) {
+                    return segment.slots[a].program_id < segment.slots[b].program_id;
+                });
+
+                for (std::size_t i = 0; i < n; ++i)
+                {
+                    run_job(segment.slots[batch[i]]);
+                }
+
+                segment.batches.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+    private:
+        void run_job(job_slot& slot)
+        {
+            auto& state = slot.state;
+
+            if (!has_image || slot.program_id != image_program)
+            {
+                unpack_state(state, image);
+                std::copy(state.memory, state.memory + machine::memory_size, image_memory);
+                image_program = slot.program_id;
+                has_image = true;
+            }
+            else
+            {
+                for (int addr = 0; addr < machine::memory_size; ++addr)
+                {
+                    if (state.memory[addr] != image_memory[addr])
+                    {
+                        image_memory[addr] = state.memory[addr];
+                        image.memory[addr] = word::unpack(state.memory[addr]);
+                    }
+                }
+            }
+
+            work = image;
+            unpack_registers(state, work);
+            const auto result = run_sandboxed(work, segment.cycle_budget, &segment.stopping);
+            pack_state(work, state);
+
+            slot.finish_time = job_clock_ns();
+            segment.latency.add(slot.finish_time - slot.submit_time);
+            segment.completed.fetch_add(1, std::memory_order_relaxed);
+            if (result != sandbox_result::HALTED)
+            {
+                segment.failed.fetch_add(1, std::memory_order_relaxed);
+            }
+            slot.status.store(status_of(result), std::memory_order_release);
+        }
+
+        static bool claim(job_slot& slot)
+        {
+            std::uint32_t queued = JOB_QUEUED;
+            return slot.status.compare_exchange_strong(queued, JOB_RUNNING, std::memory_order_acquire);
+        }
+
+        static job_status status_of(sandbox_result result)
+        {
+            switch (result)
+            {
+                case sandbox_result::HALTED:
+                    return JOB_DONE;
+                case sandbox_result::FAULT:
+                    return JOB_FAULT;
+                case sandbox_result::OVER_BUDGET:
+                    return JOB_OVER_BUDGET;
+                default:
+                    return JOB_CANCELLED;
+            }
+        }
+
+        void record_depth(std::uint64_t depth)
+        {
+            auto max = segment.max_queue_depth.load(std::memory_order_relaxed);
+            while (depth > max && !segment.max_queue_depth.compare_exchange_weak(max, depth, std::memory_order_relaxed)) {}
+        }
+
+        static void back_off(int idle)
+        {
+            if (idle < 64)
+            {
+                std::this_thread::yield();
+            }
+            else
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+        }
+
+        job_segment& segment;
+        int n_workers;
+        machine image;
+        machine work;
+        std::uint32_t image_memory[machine::memory_size] = {};
+        std::uint64_t image_program = 0;
+        bool has_image = false;
+    };
+
+    mapped_job_segment segment;
+    int n_workers;
+    std::vector<std::thread> workers;
+};
+
+}
+
+#endif
@@ -1,6 +1,7 @@
 #ifndef CCMIX_MACHINE_HPP
 #define CCMIX_MACHINE_HPP
 
+#include "ccmix/mix_float.hpp"
 #include "ccmix/word.hpp"
 #include <cstdint>
 
@@ -64,9 +65,21 @@ enum opcode
     CMPX = 63
 };
 
+// ADD, SUB, MUL, DIV and CMPA with this modification are FADD, FSUB, FMUL, FDIV and FCMP
+enum float_opcode_mod
+{
+    FLOAT = 6
+};
+
 enum special_opcode_mod
 {
-    HLT = 2
+    HLT = 2,
+    FLOT = 6,
+    FIX = 7,
+
+    // Extensions for shared memory multiprocessing
+    XCH = 16,
+    CAS = 17
 };
 
 enum jmp_opcode_mod
@@ -106,17 +119,50 @@ enum class comparison_result
     GREATER
 };
 
-class machine
+// Debug policy of a normal run. A debug policy gets to stop execution before an instruction, knowing the
+// cycles taken so far, and sees every memory access made by load and store instructions. See debugger for
+// the real one.
+struct no_debug
+{
+    static constexpr bool enabled = false;
+
+    constexpr bool break_at(int, std::uint64_t) const { return false; }
+    constexpr void on_read(int, field_spec, int) {}
+    constexpr void on_write(int, field_spec, int) {}
+    constexpr bool stopped() const { return false; }
+};
+
+// The registers of a MIX processor. The memory is given to execute(), so that several processors can
+// share one memory. Memory must provide read(), write(), exchange() and compare_exchange() like local_memory.
+class cpu
 {
 public:
-    constexpr void run()
+    template <class Memory>
+    constexpr void execute(Memory& memory)
+    {
+        no_debug debug;
+        execute(memory, debug);
+    }
+
+    template <class Memory, class Debug>
+    constexpr void execute(Memory& memory, Debug& debug)
     {
+        // The registers are kept unboxed for the duration of the run, and written back on exit
+        auto r = unbox_registers();
+        auto elapsed = cycles;
+        auto not_counted_loop = -1;
         auto halted = false;
 
         while (!halted)
         {
-            const auto instruction = memory[pc];
+            if (Debug::enabled && debug.break_at(pc, elapsed))
+            {
+                break;
+            }
+
+            const auto instruction = memory.read(pc);
             const auto opcode = instruction.opcode();
+            elapsed += timing(instruction);
 
             // by default, the next instruction is the one in the following memory address
             auto next_pc = pc + 1;
@@ -124,23 +170,51 @@ public:
             switch (opcode)
             {
                 case ADD:
-                    reg_a = word{reg_a.value() + load(instruction).value()};
+                    if (instruction.opcode_mod() == FLOAT)
+                    {
+                        r.a = unboxed_reg{mix_float::add(r.a.boxed(), load_float(memory, debug, instruction, r))};
+                        break;
+                    }
+                    r.a = unboxed_reg::from_value(r.a.value + load(memory, debug, instruction, r).value());
                     break;
 
                 case SUB:
-                    reg_a = word{reg_a.value() - load(instruction).value()};
+                    if (instruction.opcode_mod() == FLOAT)
+                    {
+                        r.a = unboxed_reg{mix_float::sub(r.a.boxed(), load_float(memory, debug, instruction, r))};
+                        break;
+                    }
+                    r.a = unboxed_reg::from_value(r.a.value - load(memory, debug, instruction, r).value());
                     break;
 
                 case MUL:
-                    set_reg_ax_value(static_cast<std::int64_t>(reg_a.value()) * load(instruction).value());
+                    if (instruction.opcode_mod() == FLOAT)
+                    {
+                        r.a = unboxed_reg{mix_float::mul(r.a.boxed(), load_float(memory, debug, instruction, r))};
+                        break;
+                    }
+                    set_ax_value(r, static_cast<std::int64_t>(r.a.value) * load(memory, debug, instruction, r).value());
                     break;
 
                 case DIV:
                 {
-                    const auto rax = reg_ax_value();
-                    const auto v = load(instruction).value();
-                    reg_a = word{static_cast<int>(rax / v)};
-                    reg_x = word{static_cast<int>(rax % v)};
+                    if (instruction.opcode_mod() == FLOAT)
+                    {
+                        r.a = unboxed_reg{mix_float::div(r.a.boxed(), load_float(memory, debug, instruction, r))};
+                        break;
+                    }
+
+                    const auto rax = ax_value(r);
+                    const auto v = load(memory, debug, instruction, r).value();
+
+                    // Like FDIV, division by zero leaves the registers as they are
+                    if (v == 0)
+                    {
+                        break;
+                    }
+
+                    r.a = unboxed_reg::from_value(static_cast<int>(rax / v));
+                    r.x = unboxed_reg::from_value(static_cast<int>(rax % v));
                     break;
                 }
 
@@ -150,13 +224,43 @@ public:
                         case HLT:
                             halted = true;
                             break;
+                        case FLOT:
+                            r.a = unboxed_reg{mix_float::from_int(r.a.boxed())};
+                            break;
+                        case FIX:
+                            r.a = unboxed_reg{mix_float::to_int(r.a.boxed())};
+                            break;
+                        case XCH:
+                        {
+                            const auto m = indexed_address(instruction, r);
+                            if (Debug::enabled)
+                            {
+                                debug.on_read(m, field_spec::all(), pc);
+                                debug.on_write(m, field_spec::all(), pc);
+                            }
+                            r.a = unboxed_reg{memory.exchange(m, r.a.boxed())};
+                            break;
+                        }
+                        case CAS:
+                        {
+                            const auto m = indexed_address(instruction, r);
+                            if (Debug::enabled)
+                            {
+                                debug.on_read(m, field_spec::all(), pc);
+                                debug.on_write(m, field_spec::all(), pc);
+                            }
+                            const auto old = memory.compare_exchange(m, r.x.boxed(), r.a.boxed());
+                            comparison_ind = compare_values(r.x.value, old.value());
+                            r.x = unboxed_reg{old};
+                            break;
+                        }
                         default:
                             break;
                     }
                     break;
 
                 case LDA:
-                    reg_a = load(instruction);
+                    r.a = unboxed_reg{load(memory, debug, instruction, r)};
                     break;
 
                 case LD1:
@@ -165,15 +269,15 @@ public:
                 case LD4:
                 case LD5:
                 case LD6:
-                    reg_i[opcode - LD1] = load(instruction);
+                    r.i[opcode - LD1] = unboxed_reg{load(memory, debug, instruction, r)};
                     break;
 
                 case LDX:
-                    reg_x = load(instruction);
+                    r.x = unboxed_reg{load(memory, debug, instruction, r)};
                     break;
 
                 case STA:
-                    store(instruction, reg_a);
+                    store(memory, debug, instruction, r, r.a.boxed());
                     break;
 
                 case ST1:
@@ -182,44 +286,44 @@ public:
                 case ST4:
                 case ST5:
                 case ST6:
-                    store(instruction, reg_i[opcode - ST1]);
+                    store(memory, debug, instruction, r, r.i[opcode - ST1].boxed());
                     break;
 
                 case STX:
-                    store(instruction, reg_x);
+                    store(memory, debug, instruction, r, r.x.boxed());
                     break;
 
                 case STJ:
-                    store(instruction, reg_j);
+                    store(memory, debug, instruction, r, r.j.boxed());
                     break;
 
                 case STZ:
-                    store(instruction, word{});
+                    store(memory, debug, instruction, r, word{});
                     break;
 
                 case JMP:
-                    next_pc = jump(instruction, next_pc);
+                    next_pc = jump(instruction, r, next_pc);
                     break;
 
                 case JA:
-                    next_pc = jump_reg(instruction, reg_a, next_pc);
-                    break;
-
                 case J1:
                 case J2:
                 case J3:
                 case J4:
                 case J5:
                 case J6:
-                    next_pc = jump_reg(instruction, reg_i[opcode - J1], next_pc);
-                    break;
-
                 case JX:
-                    next_pc = jump_reg(instruction, reg_x, next_pc);
+                    next_pc = jump_reg(instruction, r, reg_by_number(r, opcode - JA), next_pc);
+
+                    // Debugging needs every iteration to run, so that breakpoints and watchpoints can stop any of them
+                    if (!Debug::enabled && next_pc < pc && pc != not_counted_loop)
+                    {
+                        next_pc = finish_counted_loop(memory, instruction, r, next_pc, elapsed, not_counted_loop);
+                    }
                     break;
 
                 case AXA:
-                    reg_a = addr_xfer(instruction, reg_a);
+                    r.a = addr_xfer(instruction, r, r.a);
                     break;
 
                 case AX1:
@@ -228,15 +332,20 @@ public:
                 case AX4:
                 case AX5:
                 case AX6:
-                    reg_i[opcode - AX1] = addr_xfer(instruction, reg_i[opcode - AX1]);
+                    r.i[opcode - AX1] = addr_xfer(instruction, r, r.i[opcode - AX1]);
                     break;
 
                 case AXX:
-                    reg_x = addr_xfer(instruction, reg_x);
+                    r.x = addr_xfer(instruction, r, r.x);
                     break;
 
                 case CMPA:
-                    comparison_ind = compare(instruction, reg_a);
+                    if (instruction.opcode_mod() == FLOAT)
+                    {
+                        comparison_ind = float_compare(memory, debug, instruction, r);
+                        break;
+                    }
+                    comparison_ind = compare(memory, debug, instruction, r, r.a);
                     break;
 
                 case CMP1:
@@ -245,11 +354,11 @@ public:
                 case CMP4:
                 case CMP5:
                 case CMP6:
-                    comparison_ind = compare(instruction, reg_i[opcode - CMP1]);
+                    comparison_ind = compare(memory, debug, instruction, r, r.i[opcode - CMP1]);
                     break;
 
                 case CMPX:
-                    comparison_ind = compare(instruction, reg_x);
+                    comparison_ind = compare(memory, debug, instruction, r, r.x);
                     break;
 
                 default:
@@ -257,7 +366,15 @@ public:
             }
 
             pc = next_pc;
+
+            if (Debug::enabled && debug.stopped())
+            {
+                break;
+            }
         }
+
+        box_registers(r);
+        cycles = elapsed;
     }
 
     constexpr std::int64_t reg_ax_value() const
@@ -274,52 +391,317 @@ public:
         reg_a = word{static_cast<unsigned int>(abs >> word::n_bits()), neg};
     }
 
-    static constexpr auto memory_size = 4000;
-
     word reg_a;
     word reg_x;
     word reg_i[6] = {};
     word reg_j;
-    word memory[memory_size] = {};
     int pc = 0;
     comparison_result comparison_ind = comparison_result::EQUAL;
 
+    // Execution time in units of u, see timing()
+    std::uint64_t cycles = 0;
+
 private:
-    constexpr int indexed_address(word instruction) const
+    // A register as a native integer. The separate sign flag is needed for negative zero.
+    struct unboxed_reg
+    {
+        static constexpr unsigned int ABS_MASK = (1u << word::n_bits()) - 1;
+
+        constexpr unboxed_reg() : value(0), negative(false) {}
+
+        constexpr explicit unboxed_reg(word w) : value(w.value()), negative(w.negative()) {}
+
+        constexpr unboxed_reg(unsigned int abs, bool neg)
+            : value(neg ? -static_cast<int>(abs & ABS_MASK) : static_cast<int>(abs & ABS_MASK)), negative(neg) {}
+
+        // Same truncation and sign as word{v}
+        static constexpr unboxed_reg from_value(int v)
+        {
+            return unboxed_reg{static_cast<unsigned int>(v < 0 ? -v : v), v < 0};
+        }
+
+        constexpr word boxed() const
+        {
+            return word{static_cast<unsigned int>(value < 0 ? -value : value), negative};
+        }
+
+        int value;
+        bool negative;
+    };
+
+    struct register_file
+    {
+        unboxed_reg a;
+        unboxed_reg x;
+        unboxed_reg i[6];
+        unboxed_reg j;
+    };
+
+    constexpr register_file unbox_registers() const
+    {
+        register_file r;
+        r.a = unboxed_reg{reg_a};
+        r.x = unboxed_reg{reg_x};
+        for (int n = 0; n < 6; ++n)
+        {
+            r.i[n] = unboxed_reg{reg_i[n]};
+        }
+        r.j = unboxed_reg{reg_j};
+        return r;
+    }
+
+    constexpr void box_registers(const register_file& r)
+    {
+        reg_a = r.a.boxed();
+        reg_x = r.x.boxed();
+        for (int n = 0; n < 6; ++n)
+        {
+            reg_i[n] = r.i[n].boxed();
+        }
+        reg_j = r.j.boxed();
+    }
+
+    static constexpr std::int64_t ax_value(const register_file& r)
+    {
+        const std::uint64_t abs =
+            static_cast<std::uint64_t>(r.a.value < 0 ? -r.a.value : r.a.value) << word::n_bits()
+            | static_cast<unsigned int>(r.x.value < 0 ? -r.x.value : r.x.value);
+        return r.a.negative ? -abs : abs;
+    }
+
+    static constexpr void set_ax_value(register_file& r, std::int64_t value)
+    {
+        const bool neg = value < 0;
+        const std::uint64_t abs = neg ? -value : value;
+        r.x = unboxed_reg{static_cast<unsigned int>(abs), neg};
+        r.a = unboxed_reg{static_cast<unsigned int>(abs >> word::n_bits()), neg};
+    }
+
+    // AXA, AX1-AX6 and AXX, or JA, J1-J6 and JX, in the order of their opcodes
+    static constexpr unboxed_reg& reg_by_number(register_file& r, unsigned int n)
+    {
+        return n == 0 ? r.a : n == 7 ? r.x : r.i[n - 1];
+    }
+
+    // ADD-SPECIAL and CMPA, whose times depend on the modification
+    static constexpr std::uint64_t ARITHMETIC_OPCODES = 0x010000000000003E;
+
+    // LDA-STZ and CMPA-CMPX
+    static constexpr std::uint64_t TWO_CYCLE_OPCODES = 0xFF000003FFFFFF00;
+
+    // Execution times from TAOCP sections 1.3.1 and 4.2.1. The multiprocessing extensions take as long as
+    // a load, and the instructions that aren't simulated are charged like NOP.
+    static constexpr unsigned int timing(word instruction)
+    {
+        const auto opcode = instruction.opcode();
+
+        if ((ARITHMETIC_OPCODES >> opcode & 1) == 0)
+        {
+            return 1 + (TWO_CYCLE_OPCODES >> opcode & 1);
+        }
+
+        const auto mod = instruction.opcode_mod();
+
+        switch (opcode)
+        {
+            case ADD:
+            case SUB:
+            case CMPA:
+                return mod == FLOAT ? 4 : 2;
+            case MUL:
+                return mod == FLOAT ? 9 : 10;
+            case DIV:
+                return mod == FLOAT ? 11 : 12;
+            case SPECIAL:
+                return mod == FLOT || mod == FIX ? 3 : mod == XCH || mod == CAS ? 2 : 10;
+            default:
+                return 1;
+        }
+    }
+
+    // Called for a taken backward JA, J1-J6 or JX. If the loop it closes only adds constants to registers,
+    // like DEC1 1; J1P *-1 does, the rest of its iterations are done at once, and the returned next pc is the
+    // location after the jump. Loops that wouldn't end before a register overflows run as usual.
+    //
+    // The location of the last jump whose loop body isn't of this kind is kept in not_counted_loop, so that
+    // the body of a busy loop isn't examined on every iteration. If the body is modified later to be of this
+    // kind, the loop just keeps running as usual.
+    template <class Memory>
+    constexpr int finish_counted_loop(
+        const Memory& memory, word jump_instruction, register_file& r, int target, std::uint64_t& elapsed, int& not_counted_loop) const
+    {
+        if (jump_instruction.index_spec() != 0)
+        {
+            not_counted_loop = pc;
+            return target;
+        }
+
+        for (auto addr = target; addr < pc; ++addr)
+        {
+            const auto instruction = memory.read(addr);
+            const auto opcode = instruction.opcode();
+            if (opcode < AXA || opcode > AXX || instruction.index_spec() != 0 || instruction.opcode_mod() > DEC)
+            {
+                not_counted_loop = pc;
+                return target;
+            }
+        }
+
+        // Per register: the change in one iteration, and its smallest and largest partial sums
+        std::int64_t step[8] = {};
+        std::int64_t low[8] = {};
+        std::int64_t high[8] = {};
+        bool changed[8] = {};
+        std::uint64_t iteration_time = timing(jump_instruction);
+
+        for (auto addr = target; addr < pc; ++addr)
+        {
+            const auto instruction = memory.read(addr);
+            const auto i = instruction.opcode() - AXA;
+            const auto m = instruction.address();
+            step[i] += instruction.opcode_mod() == INC ? m : -m;
+            low[i] = step[i] < low[i] ? step[i] : low[i];
+            high[i] = step[i] > high[i] ? step[i] : high[i];
+            changed[i] = true;
+            iteration_time += timing(instruction);
+        }
+
+        // Iterations left; the jump of the last one isn't taken
+        const auto counter = jump_instruction.opcode() - JA;
+        const auto n = trip_count(jump_instruction, reg_by_number(r, counter).value, step[counter]);
+        if (n == 0)
+        {
+            return target;
+        }
+
+        // Every value a register goes through lies between its values in the first and the last iteration
+        const std::int64_t limit = unboxed_reg::ABS_MASK;
+        for (unsigned int i = 0; i < 8; ++i)
+        {
+            const std::int64_t first = reg_by_number(r, i).value;
+            const auto last = first + (n - 1) * step[i];
+            const auto lowest = (first < last ? first : last) + low[i];
+            const auto highest = (first > last ? first : last) + high[i];
+            if (lowest < -limit || highest > limit)
+            {
+                return target;
+            }
+        }
+
+        for (unsigned int i = 0; i < 8; ++i)
+        {
+            if (changed[i])
+            {
+                auto& reg = reg_by_number(r, i);
+                reg = unboxed_reg::from_value(static_cast<int>(reg.value + n * step[i]));
+            }
+        }
+
+        elapsed += static_cast<std::uint64_t>(n) * iteration_time;
+        return pc + 1;
+    }
+
+    // Number of steps by d that it takes from x until the jump isn't taken, or 0 if that never happens
+    static constexpr std::int64_t trip_count(word jump_instruction, std::int64_t x, std::int64_t d)
+    {
+        switch (jump_instruction.opcode_mod())
+        {
+            case NEGATIVE:
+                return d > 0 ? (-x + d - 1) / d : 0;
+            case ZERO:
+                return d != 0 ? 1 : 0;
+            case POSITIVE:
+                return d < 0 ? (x - d - 1) / -d : 0;
+            case NONNEGATIVE:
+                return d < 0 ? x / -d + 1 : 0;
+            case NONZERO:
+                return d != 0 && x % d == 0 && x / d < 0 ? -x / d : 0;
+            case NONPOSITIVE:
+                return d > 0 ? -x / d + 1 : 0;
+            default:
+                return 0;
+        }
+    }
+
+    static constexpr int indexed_address(word instruction, const register_file& r)
     {
         const auto a = instruction.address();
         const auto i = instruction.index_spec();
-        return i == 0 ? a : a + reg_i[i - 1].value();
+        return i == 0 ? a : a + r.i[i - 1].value;
     }
 
-    constexpr word load(word instruction) const
+    template <class Memory, class Debug>
+    constexpr word load(const Memory& memory, Debug& debug, word instruction, const register_file& r) const
     {
-    	return memory[indexed_address(instruction)].field(field_spec(instruction.opcode_mod()));
+        const auto m = indexed_address(instruction, r);
+        const auto f = field_spec(instruction.opcode_mod());
+        if (Debug::enabled)
+        {
+            debug.on_read(m, f, pc);
+        }
+
+        // Full words skip the byte copying of field() during constant evaluation
+        if (CCMIX_IS_CONSTANT_EVALUATED() && f.as_opcode_mod() == field_spec::all().as_opcode_mod())
+        {
+            return memory.read(m);
+        }
+        return memory.read(m).field(f);
     }
 
-    constexpr word addr_xfer(word instruction, word reg) const
+    static constexpr unboxed_reg addr_xfer(word instruction, const register_file& r, unboxed_reg reg)
     {
-        const auto m = indexed_address(instruction);
+        const auto m = indexed_address(instruction, r);
         switch (instruction.opcode_mod())
         {
             case INC:
-                return word{reg.value() + m};
+                return unboxed_reg::from_value(reg.value + m);
             case DEC:
-                return word{reg.value() - m};
+                return unboxed_reg::from_value(reg.value - m);
             case ENT:
-                return m != 0 ? word{m} : word{0, instruction.negative()};
+                return m != 0 ? unboxed_reg::from_value(m) : unboxed_reg{0, instruction.negative()};
             case ENN:
-                return m != 0 ? word{-m} : word{0, !instruction.negative()};
+                return m != 0 ? unboxed_reg::from_value(-m) : unboxed_reg{0, !instruction.negative()};
             default:
                 return reg;
         }
     }
 
-    constexpr comparison_result compare(word instruction, word reg) const
+    // Floating point operands are always full words
+    template <class Memory, class Debug>
+    constexpr word load_float(const Memory& memory, Debug& debug, word instruction, const register_file& r) const
+    {
+        const auto m = indexed_address(instruction, r);
+        if (Debug::enabled)
+        {
+            debug.on_read(m, field_spec::all(), pc);
+        }
+        return memory.read(m);
+    }
+
+    // FCMP takes epsilon from location 0
+    template <class Memory, class Debug>
+    constexpr comparison_result float_compare(const Memory& memory, Debug& debug, word instruction, const register_file& r) const
+    {
+        const auto v = load_float(memory, debug, instruction, r);
+        if (Debug::enabled)
+        {
+            debug.on_read(0, field_spec::all(), pc);
+        }
+        return compare_values(mix_float::compare(r.a.boxed(), v, memory.read(0)), 0);
+    }
+
+    template <class Memory, class Debug>
+    constexpr comparison_result compare(const Memory& memory, Debug& debug, word instruction, const register_file& r, unboxed_reg reg) const
+    {
+        const auto f = field_spec(instruction.opcode_mod());
+        const auto reg_val = f.as_opcode_mod() == field_spec::all().as_opcode_mod()
+            ? reg.value
+            : reg.boxed().field(f).value();
+        return compare_values(reg_val, load(memory, debug, instruction, r).value());
+    }
+
+    static constexpr comparison_result compare_values(int reg_val, int mem_val)
     {
-        const auto reg_val = reg.field(field_spec(instruction.opcode_mod())).value();
-        const auto mem_val = load(instruction).value();
-        
         if (reg_val < mem_val)
         {
             return comparison_result::LESS;
@@ -333,64 +715,71 @@ private:
         return comparison_result::EQUAL;
     }
 
-    constexpr void store(word instruction, word data)
+    template <class Memory, class Debug>
+    constexpr void store(Memory& memory, Debug& debug, word instruction, const register_file& r, word data) const
     {
-        memory[indexed_address(instruction)].set_field(field_spec(instruction.opcode_mod()), data);
+        const auto m = indexed_address(instruction, r);
+        const auto f = field_spec(instruction.opcode_mod());
+        if (Debug::enabled)
+        {
+            debug.on_write(m, f, pc);
+        }
+        memory.write(m, f, data);
     }
 
-    constexpr int jump(word instruction, int next_pc)
+    constexpr int jump(word instruction, register_file& r, int next_pc)
     {
-        const auto m = indexed_address(instruction);
+        const auto m = indexed_address(instruction, r);
         switch (instruction.opcode_mod())
         {
             case UNCOND:
-                return jump_if(true, m, next_pc);
+                return jump_if(true, r, m, next_pc);
             case UNCOND_SAVE_J:
                 return m;
             case ON_LESS:
-                return jump_if(comparison_ind == comparison_result::LESS, m, next_pc);
+                return jump_if(comparison_ind == comparison_result::LESS, r, m, next_pc);
             case ON_EQUAL:
-                return jump_if(comparison_ind == comparison_result::EQUAL, m, next_pc);
+                return jump_if(comparison_ind == comparison_result::EQUAL, r, m, next_pc);
             case ON_GREATER:
-                return jump_if(comparison_ind == comparison_result::GREATER, m, next_pc);
+                return jump_if(comparison_ind == comparison_result::GREATER, r, m, next_pc);
             case ON_GREATER_EQUAL:
-                return jump_if(comparison_ind == comparison_result::GREATER || comparison_ind == comparison_result::EQUAL, m, next_pc);
+                return jump_if(comparison_ind == comparison_result::GREATER || comparison_ind == comparison_result::EQUAL, r, m, next_pc);
             case ON_NOT_EQUAL:
-                return jump_if(comparison_ind == comparison_result::LESS || comparison_ind == comparison_result::GREATER, m, next_pc);
+                return jump_if(comparison_ind == comparison_result::LESS || comparison_ind == comparison_result::GREATER, r, m, next_pc);
             case ON_LESS_EQUAL:
-                return jump_if(comparison_ind == comparison_result::LESS || comparison_ind == comparison_result::EQUAL, m, next_pc);
+                return jump_if(comparison_ind == comparison_result::LESS || comparison_ind == comparison_result::EQUAL, r, m, next_pc);
             default:
                 return next_pc;
         }
     }
 
-    constexpr int jump_reg(word instruction, word reg, int next_pc)
+    static constexpr int jump_reg(word instruction, register_file& r, unboxed_reg reg, int next_pc)
     {
-        const auto m = indexed_address(instruction);
+        const auto m = indexed_address(instruction, r);
         switch (instruction.opcode_mod())
         {
             case NEGATIVE:
-                return jump_if(reg.value() < 0, m, next_pc);
+                return jump_if(reg.value < 0, r, m, next_pc);
             case ZERO:
-                return jump_if(reg.value() == 0, m, next_pc);
+                return jump_if(reg.value == 0, r, m, next_pc);
             case POSITIVE:
-                return jump_if(reg.value() > 0, m, next_pc);
+                return jump_if(reg.value > 0, r, m, next_pc);
             case NONNEGATIVE:
-                return jump_if(reg.value() >= 0, m, next_pc);
+                return jump_if(reg.value >= 0, r, m, next_pc);
             case NONZERO:
-                return jump_if(reg.value() != 0, m, next_pc);
+                return jump_if(reg.value != 0, r, m, next_pc);
             case NONPOSITIVE:
-                return jump_if(reg.value() <= 0, m, next_pc);
+                return jump_if(reg.value <= 0, r, m, next_pc);
             default:
                 return next_pc;
         }
     }
 
-    constexpr int jump_if(bool cond, int jump_to, int next_pc)
+    static constexpr int jump_if(bool cond, register_file& r, int jump_to, int next_pc)
     {
         if (cond)
         {
-            reg_j = word{next_pc};
+            r.j = unboxed_reg::from_value(next_pc);
             return jump_to;
         }
         else
@@ -400,6 +789,72 @@ private:
     }
 };
 
+// Memory of a single machine, accessed without synchronization
+class local_memory
+{
+public:
+    constexpr explicit local_memory(word* cells) : cells(cells) {}
+
+    constexpr word read(int addr) const
+    {
+        return cells[addr];
+    }
+
+    constexpr void write(int addr, field_spec f, word data)
+    {
+        if (CCMIX_IS_CONSTANT_EVALUATED() && f.as_opcode_mod() == field_spec::all().as_opcode_mod())
+        {
+            cells[addr] = data;
+            return;
+        }
+        cells[addr].set_field(f, data);
+    }
+
+    constexpr word exchange(int addr, word data)
+    {
+        const auto old = cells[addr];
+        cells[addr] = data;
+        return old;
+    }
+
+    constexpr word compare_exchange(int addr, word expected, word desired)
+    {
+        const auto old = cells[addr];
+        if (old.value() == expected.value())
+        {
+            cells[addr] = desired;
+        }
+        return old;
+    }
+
+private:
+    word* cells;
+};
+
+class machine : public cpu
+{
+public:
+    constexpr void run()
+    {
+        local_memory m{memory};
+        execute(m);
+    }
+
+    // Runs until HLT, or until the debugger stops execution. Returns the reason for stopping.
+    template <class Debugger>
+    constexpr auto run(Debugger& debugger)
+    {
+        debugger.start();
+        local_memory m{memory};
+        execute(m, debugger);
+        return debugger.last_stop();
+    }
+
+    static constexpr auto memory_size = 4000;
+
+    word memory[memory_size] = {};
+};
+
 }
 
 #endif
@@ -0,0 +1,205 @@
+#ifndef CCMIX_MIX_FLOAT_HPP
+#define CCMIX_MIX_FLOAT_HPP
+
+#include "ccmix/word.hpp"
+#include <cstdint>
+
+namespace ccmix {
+
+// MIX floating point arithmetic (TAOCP section 4.2.1). A floating point word has the sign, the exponent
+// in byte 1 in excess-32 (half the byte size) and a four byte fraction in bytes 2-5.
+//
+// The results are those of Knuth's algorithms A, M and N: the exact result is normalized and rounded once.
+// When the rounding is a tie, the result is the odd one of the two candidates, as step N5 specifies for
+// bases where b/2 is even. The operations work on the packed 24-bit fraction with 64-bit integer arithmetic,
+// which is exact for all of them. Exponent overflow and underflow wrap, as there's no overflow toggle.
+class mix_float
+{
+public:
+    static constexpr int EXCESS = 32;
+
+    static constexpr word add(word u, word v)
+    {
+        if (exponent(u) < exponent(v))
+        {
+            const auto t = u;
+            u = v;
+            v = t;
+        }
+
+        const auto d = exponent(u) - exponent(v);
+
+        if (d >= 6)
+        {
+            return normalize(u.negative(), exponent(u), fraction(u), 0, false);
+        }
+
+        const auto mag_u = static_cast<std::int64_t>(fraction(u)) << (6 * d);
+        const auto mag_v = static_cast<std::int64_t>(fraction(v));
+        const auto sum = (u.negative() ? -mag_u : mag_u) + (v.negative() ? -mag_v : mag_v);
+        const auto neg = sum != 0 ? sum < 0 : u.negative();
+
+        return normalize(neg, exponent(u), static_cast<std::uint64_t>(sum < 0 ? -sum : sum), d, false);
+    }
+
+    static constexpr word sub(word u, word v)
+    {
+        return add(u, negate(v));
+    }
+
+    static constexpr word mul(word u, word v)
+    {
+        const auto mag = static_cast<std::uint64_t>(fraction(u)) * fraction(v);
+        return normalize(u.negative() != v.negative(), exponent(u) + exponent(v) - EXCESS, mag, 4, false);
+    }
+
+    // Division by zero returns u unchanged
+    static constexpr word div(word u, word v)
+    {
+        auto fu = fraction(u);
+        auto fv = fraction(v);
+        auto eu = exponent(u);
+        auto ev = exponent(v);
+        const auto neg = u.negative() != v.negative();
+
+        if (fv == 0)
+        {
+            return u;
+        }
+
+        if (fu == 0)
+        {
+            return word{0, neg};
+        }
+
+        // With normalized operands, three extra digits are enough to round the quotient correctly
+        for (; fu < MIN_NORMALIZED; fu <<= 6, --eu) {}
+        for (; fv < MIN_NORMALIZED; fv <<= 6, --ev) {}
+
+        const auto dividend = static_cast<std::uint64_t>(fu) << 36;
+        return normalize(neg, eu - ev + EXCESS + 1, dividend / fv, 3, dividend % fv != 0);
+    }
+
+    // FLOT
+    static constexpr word from_int(word w)
+    {
+        return normalize(w.negative(), EXCESS + 5, w.abs_value(), 1, false);
+    }
+
+    // FIX. Integers that don't fit in a word are truncated.
+    static constexpr word to_int(word w)
+    {
+        const auto f = fraction(w);
+        const auto shift = 6 * (exponent(w) - EXCESS - 4);
+
+        if (shift >= 0)
+        {
+            return word{shift < word::n_bits() ? f << shift : 0, w.negative()};
+        }
+
+        if (-shift > word::n_bits())
+        {
+            return word{0, w.negative()};
+        }
+
+        return word{round(f, -shift, false), w.negative()};
+    }
+
+    // FCMP: u and v are approximately equal if they differ by at most epsilon * b^(max(eu, ev) - q).
+    // As in Program 4.2.2C, the rounded difference is compared, and epsilon must be normalized.
+    // Returns -1, 0 or 1 when u is less than, approximately equal to or greater than v.
+    static constexpr int compare(word u, word v, word epsilon)
+    {
+        const auto w = sub(v, u);
+
+        if (fraction(w) == 0)
+        {
+            return 0;
+        }
+
+        const auto e = exponent(u) > exponent(v) ? exponent(u) : exponent(v);
+        const auto te = exponent(epsilon) + e - EXCESS;
+        const auto approx_equal = te > 63
+            || (te >= 0 && w.abs_value() <= (static_cast<unsigned int>(te) << 24 | fraction(epsilon)));
+
+        if (approx_equal)
+        {
+            return 0;
+        }
+
+        return w.negative() ? 1 : -1;
+    }
+
+    static constexpr int exponent(word w)
+    {
+        return static_cast<int>(w.abs_value() >> 24);
+    }
+
+    static constexpr unsigned int fraction(word w)
+    {
+        return w.abs_value() & 0xFFFFFF;
+    }
+
+private:
+    static constexpr unsigned int MIN_NORMALIZED = 1u << 18;
+
+    static constexpr word negate(word w)
+    {
+        return word{w.abs_value(), !w.negative()};
+    }
+
+    static constexpr int n_digits(std::uint64_t v)
+    {
+        auto n = 0;
+        for (; v != 0; v >>= 6, ++n) {}
+        return n;
+    }
+
+    // Rounds v / 2^bits to an integer. sticky tells that the real value is a bit more than v.
+    static constexpr unsigned int round(std::uint64_t v, int bits, bool sticky)
+    {
+        if (bits == 0)
+        {
+            return static_cast<unsigned int>(v);
+        }
+
+        const auto q = v >> bits;
+        const auto r = v & ((std::uint64_t{1} << bits) - 1);
+        const auto half = std::uint64_t{1} << (bits - 1);
+        const auto up = r > half || (r == half && (sticky || q % 2 == 0));
+        return static_cast<unsigned int>(up ? q + 1 : q);
+    }
+
+    // Algorithm N for the fraction mag / 64^(4 + k) with exponent e
+    static constexpr word normalize(bool neg, int e, std::uint64_t mag, int k, bool sticky)
+    {
+        if (mag == 0)
+        {
+            return word{0, neg};
+        }
+
+        const auto digits = n_digits(mag);
+        e += digits - 4 - k;
+        k = digits - 4;
+
+        if (k < 0)
+        {
+            mag <<= -6 * k;
+            k = 0;
+        }
+
+        auto f = round(mag, 6 * k, sticky);
+
+        if (f == 1u << 24)
+        {
+            f = MIN_NORMALIZED;
+            ++e;
+        }
+
+        return word{static_cast<unsigned int>(e & 63) << 24 | f, neg};
+    }
+};
+
+}
+
+#endif
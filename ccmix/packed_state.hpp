@@ -0,0 +1,74 @@
+#ifndef CCMIX_PACKED_STATE_HPP
+#define CCMIX_PACKED_STATE_HPP
+
+#include "ccmix/machine.hpp"
+#include <cstdint>
+
+namespace ccmix {
+
+// The whole state of a machine in fixed-size integers, with the words packed like word::pack() does.
+// It has no pointers, so it can be written to files and shared between processes.
+struct packed_state
+{
+    static constexpr int N_REGISTERS = 9;
+
+    std::uint64_t cycles = 0;
+    std::uint32_t memory[machine::memory_size] = {};
+
+    // rA, rX, rI1-rI6 and rJ
+    std::uint32_t registers[N_REGISTERS] = {};
+
+    std::int32_t pc = 0;
+    std::uint32_t comparison_ind = 0;
+};
+
+// Everything but memory
+constexpr void pack_registers(const cpu& c, packed_state& state)
+{
+    state.cycles = c.cycles;
+    state.registers[0] = c.reg_a.pack();
+    state.registers[1] = c.reg_x.pack();
+    for (int i = 0; i < 6; ++i)
+    {
+        state.registers[2 + i] = c.reg_i[i].pack();
+    }
+    state.registers[8] = c.reg_j.pack();
+    state.pc = c.pc;
+    state.comparison_ind = static_cast<std::uint32_t>(c.comparison_ind);
+}
+
+constexpr void unpack_registers(const packed_state& state, cpu& c)
+{
+    c.cycles = state.cycles;
+    c.reg_a = word::unpack(state.registers[0]);
+    c.reg_x = word::unpack(state.registers[1]);
+    for (int i = 0; i < 6; ++i)
+    {
+        c.reg_i[i] = word::unpack(state.registers[2 + i]);
+    }
+    c.reg_j = word::unpack(state.registers[8]);
+    c.pc = state.pc;
+    c.comparison_ind = static_cast<comparison_result>(state.comparison_ind);
+}
+
+constexpr void pack_state(const machine& m, packed_state& state)
+{
+    for (int addr = 0; addr < machine::memory_size; ++addr)
+    {
+        state.memory[addr] = m.memory[addr].pack();
+    }
+    pack_registers(m, state);
+}
+
+constexpr void unpack_state(const packed_state& state, machine& m)
+{
+    for (int addr = 0; addr < machine::memory_size; ++addr)
+    {
+        m.memory[addr] = word::unpack(state.memory[addr]);
+    }
+    unpack_registers(state, m);
+}
+
+}
+
+#endif
@@ -0,0 +1,341 @@
+#ifndef CCMIX_RESULT_CACHE_HPP
+#define CCMIX_RESULT_CACHE_HPP
+
+#include "ccmix/packed_state.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace ccmix {
+
+// 128-bit hash of a machine state
+struct state_key
+{
+    std::uint64_t high = 0;
+    std::uint64_t low = 0;
+
+    constexpr bool operator==(const state_key& other) const
+    {
+        return high == other.high && low == other.low;
+    }
+
+    // 32 hex digits
+    std::string to_string() const
+    {
+        char hex[33];
+        std::snprintf(hex, sizeof(hex), "%016llx%016llx",
+            static_cast<unsigned long long>(high), static_cast<unsigned long long>(low));
+        return hex;
+    }
+};
+
+// The initial state of a run, with a key that identifies it. The key is a sum of hashes of every memory
+// location and register, so after the first one, computing the key only costs as much as the memory
+// writes made since the last one. Memory is written with write(), which keeps track of the changed locations.
+class tracked_machine
+{
+public:
+    constexpr explicit tracked_machine(const machine& image) : m(image)
+    {
+        for (int addr = 0; addr < machine::memory_size; ++addr)
+        {
+            hashed[addr] = m.memory[addr].pack();
+            memory_key.high += cell_hash(HIGH_SEED, addr, hashed[addr]);
+            memory_key.low += cell_hash(LOW_SEED, addr, hashed[addr]);
+        }
+    }
+
+    constexpr word read(int addr) const
+    {
+        return m.memory[addr];
+    }
+
+    constexpr void write(int addr, word w)
+    {
+        m.memory[addr] = w;
+
+        if (!dirty[addr])
+        {
+            dirty[addr] = true;
+            dirty_list[n_dirty++] = addr;
+        }
+    }
+
+    // Registers, pc, comparison indicator and cycle count, which can be changed freely
+    constexpr ccmix::cpu& cpu()
+    {
+        return m;
+    }
+
+    constexpr const machine& state() const
+    {
+        return m;
+    }
+
+    constexpr state_key key()
+    {
+        for (int i = 0; i < n_dirty; ++i)
+        {
+            const auto addr = dirty_list[i];
+            const auto packed = m.memory[addr].pack();
+            memory_key.high += cell_hash(HIGH_SEED, addr, packed) - cell_hash(HIGH_SEED, addr, hashed[addr]);
+            memory_key.low += cell_hash(LOW_SEED, addr, packed) - cell_hash(LOW_SEED, addr, hashed[addr]);
+            hashed[addr] = packed;
+            dirty[addr] = false;
+        }
+        n_dirty = 0;
+
+        auto key = memory_key;
+        add_registers(HIGH_SEED, key.high);
+        add_registers(LOW_SEED, key.low);
+        return key;
+    }
+
+private:
+    static constexpr std::uint64_t HIGH_SEED = 0x243F6A8885A308D3;
+    static constexpr std::uint64_t LOW_SEED = 0x13198A2E03707344;
+
+    // splitmix64 finalizer
+    static constexpr std::uint64_t mix(std::uint64_t x)
+    {
+        x ^= x >> 30;
+        x *= 0xBF58476D1CE4E5B9;
+        x ^= x >> 27;
+        x *= 0x94D049BB133111EB;
+        return x ^ (x >> 31);
+    }
+
+    // The registers come after memory in the addresses
+    static constexpr std::uint64_t cell_hash(std::uint64_t seed, int addr, std::uint64_t value)
+    {
+        return mix(mix(seed + static_cast<std::uint64_t>(addr)) ^ value);
+    }
+
+    constexpr void add_registers(std::uint64_t seed, std::uint64_t& sum) const
+    {
+        auto addr = machine::memory_size;
+        sum += cell_hash(seed, addr++, m.reg_a.pack());
+        sum += cell_hash(seed, addr++, m.reg_x.pack());
+        for (const auto& reg : m.reg_i)
+        {
+            sum += cell_hash(seed, addr++, reg.pack());
+        }
+        sum += cell_hash(seed, addr++, m.reg_j.pack());
+        sum += cell_hash(seed, addr++, static_cast<std::uint32_t>(m.pc));
+        sum += cell_hash(seed, addr++, static_cast<std::uint64_t>(m.comparison_ind));
+        sum += cell_hash(seed, addr, m.cycles);
+    }
+
+    machine m;
+    state_key memory_key;
+    std::uint32_t hashed[machine::memory_size] = {};
+    bool dirty[machine::memory_size] = {};
+    std::int16_t dirty_list[machine::memory_size] = {};
+    int n_dirty = 0;
+};
+
+// Final states of earlier runs by the key of their initial state. The most recently used ones are kept
+// in memory. If a directory is given, every state is also stored there in a file named by its key, and
+// states missing from memory are looked up there. The directory must exist. Not thread safe.
+class result_cache
+{
+public:
+    explicit result_cache(std::size_t capacity, std::string directory = "")
+        : capacity(capacity), directory(std::move(directory))
+    {
+    }
+
+    // Runs a copy of the job's state into result, or restores the final state of an earlier run of the
+    // same initial state without executing it. Returns true in the latter case.
+    bool run(tracked_machine& job, machine& result)
+    {
+        const auto key = job.key();
+
+        if (find(key, result))
+        {
+            return true;
+        }
+
+        result = job.state();
+        result.run();
+        insert(key, result);
+        return false;
+    }
+
+    bool find(const state_key& key, machine& result)
+    {
+        const auto i = index.find(key);
+
+        if (i != index.end())
+        {
+            entries.splice(entries.begin(), entries, i->second);
+            unpack_state(i->second->state, result);
+            ++n_hits;
+            return true;
+        }
+
+        packed_state state;
+        if (!read_file(key, state))
+        {
+            ++n_misses;
+            return false;
+        }
+
+        add(key, state);
+        unpack_state(state, result);
+        ++n_disk_hits;
+        return true;
+    }
+
+    void insert(const state_key& key, const machine& final_state)
+    {
+        packed_state state;
+        pack_state(final_state, state);
+
+        const auto i = index.find(key);
+        if (i != index.end())
+        {
+            i->second->state = state;
+            entries.splice(entries.begin(), entries, i->second);
+        }
+        else
+        {
+            add(key, state);
+        }
+
+        write_file(key, state);
+    }
+
+    std::size_t size() const
+    {
+        return entries.size();
+    }
+
+    std::uint64_t hits() const
+    {
+        return n_hits;
+    }
+
+    std::uint64_t disk_hits() const
+    {
+        return n_disk_hits;
+    }
+
+    std::uint64_t misses() const
+    {
+        return n_misses;
+    }
+
+private:
+    static constexpr std::size_t MAGIC_SIZE = 8;
+
+    struct entry
+    {
+        state_key key;
+        packed_state state;
+    };
+
+    struct key_hash
+    {
+        std::size_t operator()(const state_key& key) const
+        {
+            return static_cast<std::size_t>(key.low);
+        }
+    };
+
+    void add(const state_key& key, const packed_state& state)
+    {
+        entries.push_front(entry{key, state});
+        index[key] = entries.begin();
+
+        if (entries.size() > capacity)
+        {
+            index.erase(entries.back().key);
+            entries.pop_back();
+        }
+    }
+
+    static const char* magic()
+    {
+        return "CCMIXRC1";
+    }
+
+    std::string file_name(const state_key& key) const
+    {
+        return directory + "/" + key.to_string();
+    }
+
+    // A file is a header, the key and the state's fields in the order of packed_state, in host byte order
+    bool read_file(const state_key& key, packed_state& state) const
+    {
+        if (directory.empty())
+        {
+            return false;
+        }
+
+        std::ifstream file{file_name(key), std::ios::binary};
+        char header[MAGIC_SIZE] = {};
+        state_key stored;
+
+        file.read(header, MAGIC_SIZE);
+        file.read(reinterpret_cast<char*>(&stored.high), sizeof(stored.high));
+        file.read(reinterpret_cast<char*>(&stored.low), sizeof(stored.low));
+        file.read(reinterpret_cast<char*>(&state.cycles), sizeof(state.cycles));
+        file.read(reinterpret_cast<char*>(state.memory), sizeof(state.memory));
+        file.read(reinterpret_cast<char*>(state.registers), sizeof(state.registers));
+        file.read(reinterpret_cast<char*>(&state.pc), sizeof(state.pc));
+        file.read(reinterpret_cast<char*>(&state.comparison_ind), sizeof(state.comparison_ind));
+
+        return file && std::equal(header, header + MAGIC_SIZE, magic()) && stored == key;
+    }
+
+    // Written to a temporary file first, so that a reader never sees a partial file
+    void write_file(const state_key& key, const packed_state& state) const
+    {
+        if (directory.empty())
+        {
+            return;
+        }
+
+        const auto name = file_name(key);
+        const auto temp_name = name + ".tmp";
+
+        {
+            std::ofstream file{temp_name, std::ios::binary};
+            file.write(magic(), MAGIC_SIZE);
+            file.write(reinterpret_cast<const char*>(&key.high), sizeof(key.high));
+            file.write(reinterpret_cast<const char*>(&key.low), sizeof(key.low));
+            file.write(reinterpret_cast<const char*>(&state.cycles), sizeof(state.cycles));
+            file.write(reinterpret_cast<const char*>(state.memory), sizeof(state.memory));
+            file.write(reinterpret_cast<const char*>(state.registers), sizeof(state.registers));
+            file.write(reinterpret_cast<const char*>(&state.pc), sizeof(state.pc));
+            file.write(reinterpret_cast<const char*>(&state.comparison_ind), sizeof(state.comparison_ind));
+
+            if (!file)
+            {
+                std::remove(temp_name.c_str());
+                return;
+            }
+        }
+
+        std::rename(temp_name.c_str(), name.c_str());
+    }
+
+    std::size_t capacity;
+    std::string directory;
+    std::list<entry> entries;
+    std::unordered_map<state_key, std::list<entry>::iterator, key_hash> index;
+    std::uint64_t n_hits = 0;
+    std::uint64_t n_disk_hits = 0;
+    std::uint64_t n_misses = 0;
+};
+
+}
+
+#endif
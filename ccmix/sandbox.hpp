@@ -0,0 +1,161 @@
+#ifndef CCMIX_SANDBOX_HPP
+#define CCMIX_SANDBOX_HPP
+
+#include "ccmix/machine.hpp"
+#include <atomic>
+#include <cstdint>
+
+namespace ccmix {
+
+enum class sandbox_result
+{
+    HALTED,
+
+    // At a pc outside memory, an instruction with an index other than 0-6 or an invalid field, or after an
+    // access to a location outside memory
+    FAULT,
+
+    OVER_BUDGET,
+    CANCELLED
+};
+
+// Memory and debug policy for running machine states from an untrusted source, such as the clients of
+// job_server, without reading or writing outside the machine.
+//
+// Execution stops before an instruction that the interpreter can't run safely, and after one that accesses
+// a location outside memory, which reads as +0 and isn't written. It also stops once the run has taken its
+// budget of cycles, or when the cancel flag is set. Counted loops run every iteration, like under debugger.
+class sandbox
+{
+public:
+    static constexpr bool enabled = true;
+
+    constexpr sandbox(word* cells, std::uint64_t start_cycles, std::uint64_t budget,
+        const std::atomic<std::uint32_t>* cancel = nullptr)
+        : cells(cells), start_cycles(start_cycles), budget(budget), cancel(cancel)
+    {
+    }
+
+    constexpr sandbox_result result() const
+    {
+        return stop;
+    }
+
+    // Memory
+
+    constexpr word read(int addr) const
+    {
+        return in_memory(addr) ? cells[addr] : word{};
+    }
+
+    constexpr void write(int addr, field_spec f, word data)
+    {
+        if (in_memory(addr))
+        {
+            cells[addr].set_field(f, data);
+        }
+    }
+
+    constexpr word exchange(int addr, word data)
+    {
+        const auto old = read(addr);
+        write(addr, field_spec::all(), data);
+        return old;
+    }
+
+    constexpr word compare_exchange(int addr, word expected, word desired)
+    {
+        const auto old = read(addr);
+        if (old.value() == expected.value())
+        {
+            write(addr, field_spec::all(), desired);
+        }
+        return old;
+    }
+
+    // Debug policy
+
+    constexpr bool break_at(int pc, std::uint64_t cycles)
+    {
+        if (!in_memory(pc) || !valid(cells[pc]))
+        {
+            stop = sandbox_result::FAULT;
+        }
+        else if (cycles - start_cycles >= budget)
+        {
+            stop = sandbox_result::OVER_BUDGET;
+        }
+        else if (cancel != nullptr && cancel->load(std::memory_order_relaxed) != 0)
+        {
+            stop = sandbox_result::CANCELLED;
+        }
+
+        return stopped();
+    }
+
+    constexpr void on_read(int addr, field_spec, int)
+    {
+        check(addr);
+    }
+
+    constexpr void on_write(int addr, field_spec, int)
+    {
+        check(addr);
+    }
+
+    constexpr bool stopped() const
+    {
+        return stop != sandbox_result::HALTED;
+    }
+
+private:
+    static constexpr bool in_memory(int addr)
+    {
+        return addr >= 0 && addr < machine::memory_size;
+    }
+
+    // The interpreter indexes registers by the index and copies bytes by the field without checking them
+    static constexpr bool valid(word instruction)
+    {
+        if (instruction.index_spec() > 6)
+        {
+            return false;
+        }
+
+        const auto op = instruction.opcode();
+        const auto mod = instruction.opcode_mod();
+        const auto arithmetic = op >= ADD && op <= DIV;
+        const auto uses_field = arithmetic || (op >= LDA && op <= LDX) || (op >= STA && op <= STZ) || op >= CMPA;
+        const auto is_float = mod == FLOAT && (arithmetic || op == CMPA);
+        const field_spec f{mod};
+
+        return !uses_field || is_float || (f.left() <= f.right() && f.right() <= 5);
+    }
+
+    constexpr void check(int addr)
+    {
+        if (!in_memory(addr))
+        {
+            stop = sandbox_result::FAULT;
+        }
+    }
+
+    word* cells;
+    std::uint64_t start_cycles;
+    std::uint64_t budget;
+    const std::atomic<std::uint32_t>* cancel;
+    sandbox_result stop = sandbox_result::HALTED;
+};
+
+// Runs the machine until it halts or the sandbox stops it
+constexpr sandbox_result run_sandboxed(machine& m, std::uint64_t budget, const std::atomic<std::uint32_t>* cancel = nullptr)
+{
+    // The sandbox is both the memory and the debug policy of the run
+    sandbox box{m.memory, m.cycles, budget, cancel};
+    m.execute(box, box);
+    return box.result();
+}
+
+}
+
+#endif
@@ -0,0 +1,148 @@
+#ifndef CCMIX_SMP_HPP
+#define CCMIX_SMP_HPP
+
+#include "ccmix/machine.hpp"
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace ccmix {
+
+// Memory shared by several processors. Every word is accessed atomically.
+class shared_memory
+{
+public:
+    explicit shared_memory(std::atomic<std::uint32_t>* cells) : cells(cells) {}
+
+    word read(int addr) const
+    {
+        return word::unpack(cells[addr].load(std::memory_order_acquire));
+    }
+
+    void write(int addr, field_spec f, word data)
+    {
+        if (f.as_opcode_mod() == field_spec::all().as_opcode_mod())
+        {
+            cells[addr].store(data.pack(), std::memory_order_release);
+            return;
+        }
+
+        // Partial stores must not lose a concurrent store to the rest of the word
+        auto old = cells[addr].load(std::memory_order_relaxed);
+        auto w = word::unpack(old);
+        w.set_field(f, data);
+        while (!cells[addr].compare_exchange_weak(old, w.pack(), std::memory_order_acq_rel))
+        {
+            w = word::unpack(old);
+            w.set_field(f, data);
+        }
+    }
+
+    word exchange(int addr, word data)
+    {
+        return word::unpack(cells[addr].exchange(data.pack(), std::memory_order_acq_rel));
+    }
+
+    word compare_exchange(int addr, word expected, word desired)
+    {
+        auto old = cells[addr].load(std::memory_order_acquire);
+        while (word::unpack(old).value() == expected.value())
+        {
+            if (cells[addr].compare_exchange_weak(old, desired.pack(), std::memory_order_acq_rel))
+            {
+                break;
+            }
+        }
+        return word::unpack(old);
+    }
+
+private:
+    std::atomic<std::uint32_t>* cells;
+};
+
+// Several MIX processors running on host threads against one shared memory.
+// Each processor has its own registers, pc and comparison indicator.
+class smp_machine
+{
+public:
+    explicit smp_machine(int n_cpus) : cpus(n_cpus)
+    {
+        for (auto& cell : memory)
+        {
+            cell.store(word{}.pack(), std::memory_order_relaxed);
+        }
+    }
+
+    int n_cpus() const
+    {
+        return static_cast<int>(cpus.size());
+    }
+
+    ccmix::cpu& cpu(int i)
+    {
+        return cpus[i].state;
+    }
+
+    const ccmix::cpu& cpu(int i) const
+    {
+        return cpus[i].state;
+    }
+
+    word load(int addr) const
+    {
+        return word::unpack(memory[addr].load(std::memory_order_acquire));
+    }
+
+    void store(int addr, word w)
+    {
+        memory[addr].store(w.pack(), std::memory_order_release);
+    }
+
+    void load_image(const word (&image)[machine::memory_size])
+    {
+        for (int addr = 0; addr < machine::memory_size; ++addr)
+        {
+            store(addr, image[addr]);
+        }
+    }
+
+    // Runs every processor on its own thread until all of them have halted
+    void run()
+    {
+        std::vector<std::thread> threads;
+        threads.reserve(cpus.size());
+
+        for (auto& c : cpus)
+        {
+            threads.emplace_back([this, &c] {
+                shared_memory m{memory};
+                c.state.execute(m);
+            });
+        }
+
+        for (auto& t : threads)
+        {
+            t.join();
+        }
+    }
+
+private:
+    static constexpr int CACHE_LINE_SIZE = 64;
+
+    // Padding on both sides keeps each processor's registers on cache lines of their own,
+    // regardless of how the vector's storage is aligned
+    struct context
+    {
+        char front_padding[CACHE_LINE_SIZE];
+        ccmix::cpu state;
+        char back_padding[CACHE_LINE_SIZE];
+    };
+
+    std::vector<context> cpus;
+    std::atomic<std::uint32_t> memory[machine::memory_size];
+};
+
+}
+
+#endif
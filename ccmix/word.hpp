@@ -3,9 +3,19 @@
 
 #include "ccmix/field_spec.hpp"
 #include <cstdint>
+#include <type_traits>
 
 namespace ccmix {
 
+// True when called during constant evaluation (C++20 and later; always false before that).
+// The constant evaluator executes every loop iteration and operation as written, so word takes
+// a path with fewer operations there. At run time the byte loops are left to the optimizer.
+#if defined(__cpp_lib_is_constant_evaluated)
+#define CCMIX_IS_CONSTANT_EVALUATED() std::is_constant_evaluated()
+#else
+#define CCMIX_IS_CONSTANT_EVALUATED() false
+#endif
+
 class word
 {
 public:
@@ -17,12 +27,14 @@ public:
     constexpr word() {}
 
     constexpr word(unsigned int abs_value, bool negative)
+        : neg(negative),
+          data{
+              abs_value,
+              abs_value >> byte::N_BITS,
+              abs_value >> (2 * byte::N_BITS),
+              abs_value >> (3 * byte::N_BITS),
+              abs_value >> (4 * byte::N_BITS)}
     {
-        neg = negative;
-        for (int i = 0; i < N_BYTES; ++i)
-        {
-            data[i] = abs_value >> (i * byte::N_BITS);
-        }
     }
 
     constexpr word(int value) : word(value < 0 ? -value : value, value < 0) {}
@@ -43,6 +55,17 @@ public:
         data[ADDR_HIGH_BYTE] = abs_addr >> byte::N_BITS;
     }
 
+    // The sign and value in 31 bits, e.g. for storing a word in an atomic integer
+    static constexpr word unpack(std::uint32_t packed)
+    {
+        return word{packed & ~PACKED_SIGN, (packed & PACKED_SIGN) != 0};
+    }
+
+    constexpr std::uint32_t pack() const
+    {
+        return abs_value() | (neg ? PACKED_SIGN : 0);
+    }
+
     constexpr bool negative() const
     {
         return neg;
@@ -50,6 +73,15 @@ public:
 
     constexpr unsigned int abs_value() const
     {
+        if (CCMIX_IS_CONSTANT_EVALUATED())
+        {
+            return data[0]
+                | data[1] << byte::N_BITS
+                | data[2] << (2 * byte::N_BITS)
+                | data[3] << (3 * byte::N_BITS)
+                | data[4] << (4 * byte::N_BITS);
+        }
+
         unsigned int val = 0;
 
         for (int i = 0; i < N_BYTES; ++i)
@@ -134,6 +166,7 @@ private:
     static constexpr int INDEX_BYTE = 2;
     static constexpr int ADDR_LOW_BYTE = 3;
     static constexpr int ADDR_HIGH_BYTE = 4;
+    static constexpr std::uint32_t PACKED_SIGN = 1u << 30;
 
     class byte
     {
@@ -0,0 +1,92 @@
+// Job server for running MIX machines submitted by other processes through POSIX shared memory.
+// See ccmix/job_client.hpp for submitting jobs.
+//
+// Usage: ccmix_server [--replace] [segment name [workers [cycle budget]]]
+// Prints metrics every second until interrupted. An existing segment with the same name is only taken over
+// with --replace, e.g. one left behind by a server that was killed.
+#include "ccmix/job_server.hpp"
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+using namespace ccmix;
+
+namespace {
+
+volatile std::sig_atomic_t interrupted = 0;
+
+void on_signal(int)
+{
+    interrupted = 1;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    const auto replace = argc > 1 && std::strcmp(argv[1], "--replace") == 0;
+    if (replace)
+    {
+        --argc;
+        ++argv;
+    }
+
+    const auto name = argc > 1 ? argv[1] : "/ccmix";
+    const auto n_workers = argc > 2 ? std::atoi(argv[2]) : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    const auto cycle_budget = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : job_server::DEFAULT_CYCLE_BUDGET;
+
+    if (n_workers < 1 || cycle_budget < 1)
+    {
+        std::cerr << "usage: ccmix_server [--replace] [segment name [workers [cycle budget]]]\n";
+        return 2;
+    }
+
+    job_server server{name, n_workers, cycle_budget, replace};
+    if (!server)
+    {
+        std::cerr << "can't create shared memory segment " << name << ": " << std::strerror(errno) << '\n';
+        if (errno == EEXIST)
+        {
+            std::cerr << "another server may be using it, see --replace\n";
+        }
+        return 1;
+    }
+
+    std::signal(SIGINT, on_signal);
+    std::signal(SIGTERM, on_signal);
+    server.start();
+
+    std::cout << "serving " << name << " with " << n_workers << " workers and a budget of " << cycle_budget
+              << " cycles\n";
+    std::cout << "jobs/s\tfailed\tqueue\tmax queue\tjobs/batch\tp50 us\tp99 us\n";
+
+    const auto& metrics = server.metrics();
+    std::uint64_t last_completed = 0;
+    std::uint64_t last_failed = 0;
+    std::uint64_t last_batches = 0;
+
+    while (!interrupted)
+    {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+
+        const auto completed = metrics.completed.load(std::memory_order_relaxed);
+        const auto failed = metrics.failed.load(std::memory_order_relaxed);
+        const auto batches = metrics.batches.load(std::memory_order_relaxed);
+        const auto jobs_per_batch = batches > last_batches
+            ? static_cast<double>(completed - last_completed) / (batches - last_batches)
+            : 0.0;
+
+        std::cout << completed - last_completed << '\t' << failed - last_failed << '\t' << metrics.queued_jobs.size()
+                  << '\t' << metrics.max_queue_depth.load(std::memory_order_relaxed) << '\t' << jobs_per_batch << '\t'
+                  << metrics.latency.percentile(50) / 1000.0 << '\t' << metrics.latency.percentile(99) / 1000.0
+                  << std::endl;
+
+        last_completed = completed;
+        last_failed = failed;
+        last_batches = batches;
+    }
+
+    server.stop();
+}
@@ -0,0 +1,120 @@
+// Checks that job_server survives bad clients: jobs that fault or don't halt, garbage in the job queue and
+// a second server started with the same segment name. The sandbox itself is covered by test_sandbox.cpp.
+//
+// Usage: check_job_server
+#include "ccmix/job_client.hpp"
+#include "ccmix/job_server.hpp"
+#include <iostream>
+#include <string>
+
+using namespace ccmix;
+
+namespace {
+
+constexpr std::uint64_t BUDGET = 100'000;
+
+auto failures = 0;
+
+void check(bool ok, const char* what)
+{
+    if (!ok)
+    {
+        std::cerr << "FAILED: " << what << '\n';
+        ++failures;
+    }
+}
+
+machine program(int pc, word instruction)
+{
+    machine m;
+    m.pc = pc;
+    m.memory[0] = instruction;
+    m.memory[1] = word{SPECIAL, 0, 0, HLT};
+    return m;
+}
+
+// Returns the status of the job, or JOB_FREE if it couldn't be submitted or didn't finish
+job_status run(job_client& client, const machine& m)
+{
+    const auto job = client.submit(m, 1);
+    if (job < 0 || !client.wait(job))
+    {
+        return JOB_FREE;
+    }
+
+    const auto status = client.status(job);
+    client.release(job);
+    return status;
+}
+
+void check_jobs(const char* name)
+{
+    job_server server{name, 2, BUDGET};
+    check(static_cast<bool>(server), "server starts");
+    server.start();
+
+    job_server second{name, 1};
+    check(!second, "second server with the same name fails");
+
+    job_client client{name};
+    check(static_cast<bool>(client), "client connects");
+
+    const auto job = client.submit(program(0, word{AXA, 42, 0, ENT}), 1);
+    check(client.wait(job) && client.status(job) == JOB_DONE, "halting job is done");
+    check(word::unpack(client.result(job).registers[0]).value() == 42, "result of a halting job");
+    client.release(job);
+
+    check(run(client, program(5000, word{})) == JOB_FAULT, "pc outside memory");
+    check(run(client, program(0, word{LDA, 1000, 9})) == JOB_FAULT, "invalid index");
+    check(run(client, program(0, word{STA, -5})) == JOB_FAULT, "store outside memory");
+    check(run(client, program(0, word{JMP, 0})) == JOB_OVER_BUDGET, "job that doesn't halt");
+
+    // Indices that aren't queued jobs are skipped
+    auto segment = mapped_job_segment::open(name);
+    std::uint32_t free_slot = 0;
+    segment->free_slots.pop(free_slot);
+    segment->queued_jobs.push(JOB_SLOTS + 7);
+    segment->queued_jobs.push(free_slot);
+
+    check(run(client, program(0, word{AXA, 1, 0, ENT})) == JOB_DONE, "job after bad indices");
+    check(segment->slots[free_slot].status.load() == JOB_FREE, "free slot isn't run");
+    segment->free_slots.push(free_slot);
+
+    check(server.metrics().failed.load() == 4, "failed jobs are counted");
+}
+
+// stop() cancels a job that would run for a very long time
+void check_stop(const char* name)
+{
+    job_server server{name, 1, ~std::uint64_t{0}};
+    server.start();
+
+    job_client client{name};
+    const auto job = client.submit(program(0, word{JMP, 0}), 1);
+    while (client.status(job) == JOB_QUEUED)
+    {
+        std::this_thread::yield();
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    server.stop();
+    check(std::chrono::steady_clock::now() - start < std::chrono::seconds(1), "stop() returns promptly");
+    check(client.status(job) == JOB_CANCELLED, "running job is cancelled");
+}
+
+}
+
+int main()
+{
+    const auto name = "/ccmix_check_" + std::to_string(getpid());
+
+    check_jobs(name.c_str());
+    check_stop(name.c_str());
+
+    if (failures > 0)
+    {
+        return 1;
+    }
+
+    std::cout << "job_server checks passed\n";
+}
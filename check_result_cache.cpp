@@ -0,0 +1,201 @@
+// Checks the run time half of result_cache, which the static_asserts in test_result_cache.cpp can't reach:
+// LRU eviction and promotion, the files in the cache directory and the checks made when reading them.
+//
+// Usage: check_result_cache
+// Creates a scratch directory in the current directory and removes it when done.
+#include "ccmix/result_cache.hpp"
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace ccmix;
+
+namespace {
+
+constexpr int INPUT = 1000;
+
+auto failures = 0;
+
+void check(bool ok, const char* what)
+{
+    if (!ok)
+    {
+        std::cerr << "FAILED: " << what << '\n';
+        ++failures;
+    }
+}
+
+// Multiplies the input by 3 in a loop, to have some cycles and registers in the final state
+machine program()
+{
+    machine m;
+    m.memory[0] = word{AX1, 3, 0, ENT};
+    m.memory[1] = word{ADD, INPUT};
+    m.memory[2] = word{AX1, 1, 0, DEC};
+    m.memory[3] = word{J1, 1, 0, POSITIVE};
+    m.memory[4] = word{STA, INPUT + 1};
+    m.memory[5] = word{SPECIAL, 0, 0, HLT};
+    return m;
+}
+
+machine expected(int input)
+{
+    auto m = program();
+    m.memory[INPUT] = word{input};
+    m.run();
+    return m;
+}
+
+bool same_state(const machine& a, const machine& b)
+{
+    packed_state pa;
+    packed_state pb;
+    pack_state(a, pa);
+    pack_state(b, pb);
+    return pa.cycles == pb.cycles && std::equal(pa.memory, pa.memory + machine::memory_size, pb.memory)
+        && std::equal(pa.registers, pa.registers + packed_state::N_REGISTERS, pb.registers) && pa.pc == pb.pc
+        && pa.comparison_ind == pb.comparison_ind;
+}
+
+state_key key_of(int input)
+{
+    tracked_machine job{program()};
+    job.write(INPUT, word{input});
+    return job.key();
+}
+
+// Runs the program with the input through the cache and checks the final state
+bool run(result_cache& cache, int input, const char* what)
+{
+    tracked_machine job{program()};
+    job.write(INPUT, word{input});
+    machine result;
+    const auto restored = cache.run(job, result);
+    check(same_state(result, expected(input)), what);
+    return restored;
+}
+
+bool counts(const result_cache& cache, std::uint64_t hits, std::uint64_t disk_hits, std::uint64_t misses)
+{
+    return cache.hits() == hits && cache.disk_hits() == disk_hits && cache.misses() == misses;
+}
+
+bool file_exists(const std::string& name)
+{
+    return static_cast<bool>(std::ifstream{name, std::ios::binary});
+}
+
+std::vector<char> read_file(const std::string& name)
+{
+    std::ifstream file{name, std::ios::binary};
+    return std::vector<char>{std::istreambuf_iterator<char>{file}, {}};
+}
+
+void write_file(const std::string& name, const std::vector<char>& contents)
+{
+    std::ofstream{name, std::ios::binary}.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+}
+
+void check_memory_only()
+{
+    result_cache cache{2};
+
+    check(!run(cache, 1, "first run"), "first run is a miss");
+    check(run(cache, 1, "repeated run"), "repeated run is a hit");
+    check(!run(cache, 2, "second input"), "second input is a miss");
+    check(!run(cache, 3, "third input"), "third input is a miss");
+    check(cache.size() == 2, "capacity is kept");
+
+    // 1 is the least recently used one
+    check(!run(cache, 1, "evicted input"), "least recently used state is evicted");
+
+    // Using 3 makes 1 the least recently used one again
+    check(run(cache, 3, "promoted input"), "recently used state stays");
+    run(cache, 2, "refilled input");
+    check(run(cache, 3, "promotion"), "promoted state is not evicted");
+    check(counts(cache, 3, 0, 5), "hit and miss counts without a directory");
+}
+
+void check_directory(const std::string& dir)
+{
+    {
+        result_cache cache{1, dir};
+        run(cache, 1, "first run with directory");
+        run(cache, 2, "second run with directory");
+
+        // 1 was evicted from memory, but not from the directory
+        check(run(cache, 1, "state from file"), "evicted state is read from its file");
+        check(counts(cache, 0, 1, 2), "disk hit counts");
+
+        const auto name = dir + "/" + key_of(1).to_string();
+        check(file_exists(name), "file named by the key");
+        check(!file_exists(name + ".tmp"), "temporary file renamed");
+    }
+
+    // A new cache finds every earlier result in the directory
+    result_cache cache{4, dir};
+    check(run(cache, 2, "state from an earlier cache"), "files outlive the cache");
+    check(counts(cache, 0, 1, 0), "disk hit counts of a new cache");
+
+    // A file with a different key or a bad header is not used
+    const auto name1 = dir + "/" + key_of(1).to_string();
+    const auto name2 = dir + "/" + key_of(2).to_string();
+    const auto name3 = dir + "/" + key_of(3).to_string();
+    const auto contents1 = read_file(name1);
+    auto contents2 = read_file(name2);
+    write_file(name3, contents2);
+
+    // Everything but the header is right
+    auto bad_header = contents1;
+    bad_header[0] = 'X';
+    write_file(name1, bad_header);
+
+    result_cache checked{4, dir};
+    check(!run(checked, 3, "file with another key"), "file with another key is a miss");
+    check(!run(checked, 1, "file with a bad header"), "file with a bad header is a miss");
+
+    // A truncated file is a miss too
+    contents2.resize(100);
+    write_file(name2, contents2);
+    check(!run(checked, 2, "truncated file"), "truncated file is a miss");
+    check(counts(checked, 0, 0, 3), "misses of bad files");
+
+    // The misses rewrote the files, so they are good again
+    result_cache rewritten{4, dir};
+    run(rewritten, 1, "rewritten header");
+    run(rewritten, 2, "rewritten truncated file");
+    run(rewritten, 3, "rewritten key");
+    check(counts(rewritten, 0, 3, 0), "bad files are replaced");
+
+    for (const auto& name : {name1, name2, name3})
+    {
+        std::remove(name.c_str());
+    }
+}
+
+}
+
+int main()
+{
+    check_memory_only();
+
+    char dir[] = "check_result_cache.XXXXXX";
+    if (mkdtemp(dir) == nullptr)
+    {
+        std::cerr << "can't create a scratch directory\n";
+        return 1;
+    }
+
+    check_directory(dir);
+    rmdir(dir);
+
+    if (failures > 0)
+    {
+        return 1;
+    }
+
+    std::cout << "result_cache checks passed\n";
+}
@@ -0,0 +1,105 @@
+#include "ccmix/analysis.hpp"
+
+namespace ccmix {
+
+constexpr auto find_max_program()
+{
+    machine m;
+    m.memory[0] = word{AX3, 0, 1, ENT};
+    m.memory[1] = word{JMP, 4, 0, UNCOND};
+    m.memory[2] = word{CMPA, 1000, 3};
+    m.memory[3] = word{JMP, 6, 0, ON_GREATER_EQUAL};
+    m.memory[4] = word{AX2, 0, 3, ENT};
+    m.memory[5] = word{LDA, 1000, 3};
+    m.memory[6] = word{AX3, 1, 0, DEC};
+    m.memory[7] = word{J3, 2, 0, POSITIVE};
+    m.memory[8] = word{SPECIAL, 0, 0, HLT};
+    return m;
+}
+
+constexpr auto test_find_max_analysis()
+{
+    const auto m = find_max_program();
+    const program_analysis a{m.memory};
+    return a.n_blocks() == 5
+        && a.n_loops() == 2
+        && a.is_loop_header(4)
+        && a.is_loop_header(6)
+        && !a.is_loop_header(2)
+        && a.is_block_leader(4)
+        && !a.is_block_leader(5)
+        && a.is_code(8)
+        && !a.is_code(9)
+        && !a.may_self_modify()
+        && a.is_pure_code(5);
+}
+
+static_assert(test_find_max_analysis(), "");
+
+constexpr auto test_self_modifying(word store)
+{
+    machine m;
+    m.memory[0] = store;
+    m.memory[1] = word{JMP, 3, 0, UNCOND};
+    m.memory[2] = word{SPECIAL, 0, 0, HLT};
+    m.memory[3] = word{SPECIAL, 0, 0, HLT};
+    const program_analysis a{m.memory};
+    return a.may_self_modify();
+}
+
+static_assert(test_self_modifying(word{STJ, 3, 0, field_spec{4, 5}.as_opcode_mod()}), "");
+static_assert(!test_self_modifying(word{STJ, 2, 0, field_spec{4, 5}.as_opcode_mod()}), "");
+static_assert(!test_self_modifying(word{STA, 1000}), "");
+static_assert(test_self_modifying(word{STA, 1000, 1}), "");
+static_assert(test_self_modifying(word{SPECIAL, 3, 0, XCH}), "");
+
+constexpr auto test_unknown_jump()
+{
+    machine m;
+    m.memory[0] = word{STA, 1000};
+    m.memory[1] = word{JMP, 0, 1, UNCOND};
+    const program_analysis a{m.memory};
+    return a.has_unknown_jumps() && a.may_self_modify() && !a.is_pure_code(0) && !a.is_code(2);
+}
+
+static_assert(test_unknown_jump(), "");
+
+// Stores that only an indexed jump can reach
+constexpr auto test_unreached_store_after_jump()
+{
+    machine m;
+    m.memory[0] = word{JMP, 0, 1, UNCOND};
+    m.memory[5] = word{STA, 0};
+    m.memory[6] = word{SPECIAL, 0, 0, HLT};
+    const program_analysis a{m.memory};
+    return a.may_self_modify() && !a.is_pure_code(0) && !a.is_code(5);
+}
+
+static_assert(test_unreached_store_after_jump(), "");
+
+constexpr auto test_unreached_store_after_branch()
+{
+    machine m;
+    m.memory[0] = word{J1, 0, 1, POSITIVE};
+    m.memory[1] = word{SPECIAL, 0, 0, HLT};
+    m.memory[10] = word{ST1, 1};
+    const program_analysis a{m.memory};
+    return a.may_self_modify() && !a.is_pure_code(0) && !a.is_pure_code(1) && !a.is_code(10);
+}
+
+static_assert(test_unreached_store_after_branch(), "");
+
+// Without stores anywhere, an indexed jump can't make the program modify itself
+constexpr auto test_unknown_jump_without_stores()
+{
+    machine m;
+    m.memory[0] = word{JMP, 0, 1, UNCOND};
+    m.memory[5] = word{LDA, 0};
+    m.memory[6] = word{SPECIAL, 0, 0, HLT};
+    const program_analysis a{m.memory};
+    return !a.may_self_modify() && a.is_pure_code(0);
+}
+
+static_assert(test_unknown_jump_without_stores(), "");
+
+}
@@ -0,0 +1,45 @@
+#include "ccmix/bulk.hpp"
+
+namespace ccmix {
+
+constexpr auto test_import_export(std::int64_t value)
+{
+    const std::int64_t src[3] = {value, -value, 0};
+    word words[3] = {};
+    import_words(src, 3, words);
+
+    std::int32_t dest[3] = {};
+    export_words(words, 3, dest);
+    return words[0].value() == word{static_cast<int>(value)}.value() && dest[0] == words[0].value() && dest[1] == -dest[0] && dest[2] == 0;
+}
+
+static_assert(test_import_export(1), "");
+static_assert(test_import_export(1'073'741'823), "");
+static_assert(test_import_export(-123'456), "");
+
+constexpr auto test_import_truncation()
+{
+    const std::int64_t src[1] = {(std::int64_t{1} << 40) + 5};
+    word words[1] = {};
+    import_words(src, 1, words);
+    return words[0].value();
+}
+
+static_assert(test_import_truncation() == 5, "");
+
+constexpr auto test_export_field(field_spec f)
+{
+    const word words[2] = {word{-0b000001'000011'000111'001111'011111}, word{0b011111'001111'000111'000011'000001}};
+    std::int64_t dest[2] = {};
+    export_field(words, 2, f, dest);
+    return dest[0] == words[0].field(f).value() && dest[1] == words[1].field(f).value();
+}
+
+static_assert(test_export_field(field_spec{0, 0}), "");
+static_assert(test_export_field(field_spec{0, 2}), "");
+static_assert(test_export_field(field_spec::all()), "");
+static_assert(test_export_field(field_spec{1, 5}), "");
+static_assert(test_export_field(field_spec{4, 4}), "");
+static_assert(test_export_field(field_spec{2, 3}), "");
+
+}
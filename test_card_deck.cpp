@@ -0,0 +1,113 @@
+#include "ccmix/card_deck.hpp"
+#include <utility>
+
+namespace ccmix {
+
+// Two loader cards, three words at 100 and the transfer card
+constexpr char DECK[] =
+    "LOADING ROUTINE 1\n"
+    "LOADING ROUTINE 2\n"
+    "DATA 30100" "0000000001" "000000000J" "999999999~" "\n"
+    "TRANS00100\n";
+
+constexpr auto test_load()
+{
+    machine m;
+    const auto status = load_card_deck(m, DECK, sizeof(DECK) - 1);
+    return status == deck_status::LOADED && m.pc == 100
+        && m.memory[100].value() == 1
+        && m.memory[101].value() == -1
+        && m.memory[102].value() == -static_cast<int>(9'999'999'990 % (1ll << 30))
+        && m.memory[103].value() == 0;
+}
+
+static_assert(test_load(), "");
+
+// Cards split across chunks decode the same as whole ones
+constexpr auto test_load_by_char()
+{
+    machine m;
+    card_decoder decoder{m};
+    for (std::size_t i = 0; i < sizeof(DECK) - 1; ++i)
+    {
+        decoder.feed(DECK + i, 1);
+    }
+    return decoder.finish() == deck_status::LOADED && decoder.cards() == 4 && decoder.words() == 3
+        && decoder.bytes() == sizeof(DECK) - 1 && m.memory[102].negative();
+}
+
+static_assert(test_load_by_char(), "");
+
+constexpr char NEGATIVE_ZERO_DECK[] =
+    "LOAD1\n"
+    "LOAD2\n"
+    "     10005000000000~\n"
+    "TRANS00000\n";
+
+constexpr auto test_negative_zero_card()
+{
+    machine m;
+    return load_card_deck(m, NEGATIVE_ZERO_DECK, sizeof(NEGATIVE_ZERO_DECK) - 1) == deck_status::LOADED
+        && m.memory[5].value() == 0 && m.memory[5].negative();
+}
+
+static_assert(test_negative_zero_card(), "");
+
+// LDA 1000; HLT with -42 at 1000, in a deck with CRLF line ends, a blank line and no loader cards
+constexpr char PROGRAM_DECK[] =
+    "PROG 2000002621443280000000133\r\n"
+    "\r\n"
+    "PROG 11000000000004K\r\n"
+    "TRANS00000";
+
+constexpr auto test_load_and_run()
+{
+    machine m;
+    const auto status = load_card_deck(m, PROGRAM_DECK, sizeof(PROGRAM_DECK) - 1, 0);
+    m.run();
+    return status == deck_status::LOADED && m.reg_a.value() == -42;
+}
+
+static_assert(test_load_and_run(), "");
+
+constexpr auto test_error(const char* deck, std::size_t length)
+{
+    machine m;
+    card_decoder decoder{m, 0};
+    decoder.feed(deck, length);
+    const auto status = decoder.finish();
+    return std::make_pair(status, decoder.cards());
+}
+
+constexpr char BAD_DIGIT[] =
+    "     10000" "0000000001" "\n"
+    "     10001" "000000000X" "\n"
+    "TRANS00000\n";
+constexpr char BAD_COUNT[] = "     80000" "0000000001" "\n" "TRANS00000\n";
+constexpr char BAD_ADDRESS[] = "     23999" "0000000001" "0000000001" "\n" "TRANS00000\n";
+constexpr char BAD_TRANSFER[] = "TRANS04000\n";
+constexpr char NO_TRANSFER[] = "     10000" "0000000001" "\n";
+constexpr char TOO_LONG[] =
+    "     70000" "0000000001" "0000000001" "0000000001" "0000000001" "0000000001" "0000000001" "0000000001" "0" "\n"
+    "TRANS00000\n";
+
+static_assert(test_error(BAD_DIGIT, sizeof(BAD_DIGIT) - 1) == std::make_pair(deck_status::BAD_CARD, 2), "");
+static_assert(test_error(BAD_COUNT, sizeof(BAD_COUNT) - 1) == std::make_pair(deck_status::BAD_CARD, 1), "");
+static_assert(test_error(BAD_ADDRESS, sizeof(BAD_ADDRESS) - 1) == std::make_pair(deck_status::BAD_ADDRESS, 1), "");
+static_assert(test_error(BAD_TRANSFER, sizeof(BAD_TRANSFER) - 1) == std::make_pair(deck_status::BAD_ADDRESS, 1), "");
+static_assert(test_error(NO_TRANSFER, sizeof(NO_TRANSFER) - 1) == std::make_pair(deck_status::NO_TRANSFER_CARD, 1), "");
+static_assert(test_error(TOO_LONG, sizeof(TOO_LONG) - 1) == std::make_pair(deck_status::BAD_CARD, 1), "");
+
+// A bad card leaves memory untouched
+constexpr char BAD_SECOND_WORD[] = "     20007" "0000000005" "000000000X" "\n";
+
+constexpr auto test_bad_card_not_stored()
+{
+    machine m;
+    load_card_deck(m, BAD_SECOND_WORD, sizeof(BAD_SECOND_WORD) - 1, 0);
+    return m.memory[7].value() == 0;
+}
+
+static_assert(test_bad_card_not_stored(), "");
+
+}
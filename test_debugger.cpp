@@ -0,0 +1,87 @@
+#include "ccmix/debugger.hpp"
+
+namespace ccmix {
+
+constexpr auto counting_program()
+{
+    machine m;
+    m.memory[0] = word{AXA, 1, 0, INC};
+    m.memory[1] = word{STA, 1000, 0, field_spec{4, 5}.as_opcode_mod()};
+    m.memory[2] = word{LDX, 1001};
+    m.memory[3] = word{J1, 0, 0, NONZERO};
+    m.memory[4] = word{SPECIAL, 0, 0, HLT};
+    return m;
+}
+
+constexpr auto test_breakpoint()
+{
+    auto m = counting_program();
+    debugger d;
+    d.set_breakpoint(2);
+
+    const auto first = m.run(d);
+    const auto a_at_break = m.reg_a.value();
+    const auto second = m.run(d);
+
+    return first.reason == stop_reason::BREAKPOINT && first.pc == 2 && a_at_break == 1 && m.pc == 5
+        && second.reason == stop_reason::HALTED;
+}
+
+static_assert(test_breakpoint(), "");
+
+constexpr auto test_breakpoint_at_entry()
+{
+    auto m = counting_program();
+    debugger d;
+    d.set_breakpoint(0);
+
+    const auto first = m.run(d);
+    const auto pc_at_break = m.pc;
+    const auto second = m.run(d);
+
+    return first.reason == stop_reason::BREAKPOINT && first.pc == 0 && pc_at_break == 0
+        && second.reason == stop_reason::HALTED && m.reg_a.value() == 1;
+}
+
+static_assert(test_breakpoint_at_entry(), "");
+
+constexpr auto test_breakpoint_after_watchpoint()
+{
+    machine m;
+    m.memory[0] = word{STA, 1000};
+    m.memory[1] = word{AXA, 5, 0, ENT};
+    m.memory[2] = word{SPECIAL, 0, 0, HLT};
+
+    debugger d;
+    d.watch(1000, WATCH_WRITE);
+    d.set_breakpoint(1);
+
+    const auto first = m.run(d);
+    const auto pc_at_watch = m.pc;
+    const auto second = m.run(d);
+    const auto pc_at_break = m.pc;
+    const auto third = m.run(d);
+
+    return first.reason == stop_reason::WATCHPOINT && first.pc == 0 && pc_at_watch == 1
+        && second.reason == stop_reason::BREAKPOINT && second.pc == 1 && pc_at_break == 1
+        && third.reason == stop_reason::HALTED && m.reg_a.value() == 5;
+}
+
+static_assert(test_breakpoint_after_watchpoint(), "");
+
+constexpr auto test_watchpoint(int addr, watch_access access, field_spec f)
+{
+    auto m = counting_program();
+    debugger d;
+    d.watch(addr, access, f);
+    const auto stop = m.run(d);
+    return stop.reason == stop_reason::WATCHPOINT ? stop.pc * 10 + stop.access : -1;
+}
+
+static_assert(test_watchpoint(1000, WATCH_WRITE, field_spec::all()) == 10 + WATCH_WRITE, "");
+static_assert(test_watchpoint(1000, WATCH_WRITE, field_spec{5, 5}) == 10 + WATCH_WRITE, "");
+static_assert(test_watchpoint(1000, WATCH_WRITE, field_spec{0, 3}) == -1, "");
+static_assert(test_watchpoint(1000, WATCH_READ, field_spec::all()) == -1, "");
+static_assert(test_watchpoint(1001, WATCH_READ_WRITE, field_spec::all()) == 20 + WATCH_READ, "");
+
+}
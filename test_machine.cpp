@@ -1,3 +1,5 @@
+#include "ccmix/bulk.hpp"
+#include "ccmix/debugger.hpp"
 #include "ccmix/machine.hpp"
 #include <initializer_list>
 #include <utility>
@@ -95,6 +97,36 @@ constexpr auto test_div(std::int64_t a, int b)
 
 static_assert(test_div(100, 30) == std::make_pair(3, 10), "");
 static_assert(test_div(-10'000'000'000, -999'999'999) == std::make_pair(10, -10), "");
+static_assert(test_div(100, 0) == std::make_pair(0, 100), "");
+
+constexpr auto test_xch(int a, int mem)
+{
+    machine m;
+    m.reg_a = word{a};
+    m.memory[0] = word{SPECIAL, 1000, 0, XCH};
+    m.memory[1] = word{SPECIAL, 0, 0, HLT};
+    m.memory[1000] = word{mem};
+    m.run();
+    return std::make_pair(m.reg_a.value(), m.memory[1000].value());
+}
+
+static_assert(test_xch(1, 2) == std::make_pair(2, 1), "");
+
+constexpr auto test_cas(int expected, int desired, int mem)
+{
+    machine m;
+    m.reg_a = word{desired};
+    m.reg_x = word{expected};
+    m.memory[0] = word{SPECIAL, 1000, 0, CAS};
+    m.memory[1] = word{SPECIAL, 0, 0, HLT};
+    m.memory[1000] = word{mem};
+    m.run();
+    return std::make_pair(m.comparison_ind, m.memory[1000].value() * 100 + m.reg_x.value());
+}
+
+static_assert(test_cas(5, 7, 5) == std::make_pair(comparison_result::EQUAL, 705), "");
+static_assert(test_cas(4, 7, 5) == std::make_pair(comparison_result::LESS, 505), "");
+static_assert(test_cas(6, 7, 5) == std::make_pair(comparison_result::GREATER, 505), "");
 
 constexpr auto test_addr_xfer(int init, int value, addr_xfer_opcode_mod op)
 {
@@ -111,6 +143,99 @@ static_assert(test_addr_xfer(5, 2, DEC) == 3, "");
 static_assert(test_addr_xfer(5, 2, ENT) == 2, "");
 static_assert(test_addr_xfer(5, 2, ENN) == -2, "");
 
+constexpr auto test_negative_zero()
+{
+    machine m;
+    m.reg_x = word{0, true};
+    m.memory[0] = word{AXA, 0, 0, ENN}; // rA <- -0
+    m.memory[1] = word{AX1, 0, 0, ENT};
+    m.memory[2] = word{SPECIAL, 0, 0, HLT};
+    m.run();
+    return m.reg_a.negative() && m.reg_x.negative() && !m.reg_i[0].negative();
+}
+
+static_assert(test_negative_zero(), "");
+
+constexpr auto test_cycles()
+{
+    machine m;
+    m.memory[0] = word{LDA, 1000};
+    m.memory[1] = word{MUL, 1000};
+    m.memory[2] = word{AX1, 1, 0, INC};
+    m.memory[3] = word{J1, 2, 0, NEGATIVE};
+    m.memory[4] = word{ADD, 1000, 0, FLOAT};
+    m.memory[5] = word{SPECIAL, 0, 0, HLT};
+    m.run();
+    return m.cycles;
+}
+
+static_assert(test_cycles() == 2 + 10 + 1 + 1 + 4 + 10, "");
+
+// Runs a loop at location 0 followed by HLT, with and without loop acceleration, which the debugger
+// disables. The final state and the cycle count must not tell the two apart.
+constexpr auto test_loop_acceleration(std::initializer_list<word> loop, int a, int i1, int x)
+{
+    machine m;
+    m.reg_a = word{a};
+    m.reg_i[0] = word{i1};
+    m.reg_x = word{x};
+    m.reg_i[5] = word{0, true};
+
+    auto addr = 0;
+    for (const auto& instruction : loop)
+    {
+        m.memory[addr++] = instruction;
+    }
+    m.memory[addr] = word{SPECIAL, 0, 0, HLT};
+
+    auto reference = m;
+    debugger d;
+    reference.run(d);
+    m.run();
+
+    auto same = m.pc == reference.pc && m.cycles == reference.cycles
+        && m.comparison_ind == reference.comparison_ind
+        && m.reg_a.pack() == reference.reg_a.pack()
+        && m.reg_x.pack() == reference.reg_x.pack()
+        && m.reg_j.pack() == reference.reg_j.pack();
+    for (int i = 0; i < 6; ++i)
+    {
+        same = same && m.reg_i[i].pack() == reference.reg_i[i].pack();
+    }
+    return same;
+}
+
+// DEC1 1; J1P *-1 and other counted loops
+static_assert(test_loop_acceleration({word{AX1, 1, 0, DEC}, word{J1, 0, 0, POSITIVE}}, 0, 300, 0), "");
+static_assert(test_loop_acceleration({word{AX1, 3, 0, DEC}, word{J1, 0, 0, POSITIVE}}, 0, 301, 0), "");
+static_assert(test_loop_acceleration({word{AX1, 3, 0, DEC}, word{J1, 0, 0, NONNEGATIVE}}, 0, 300, 0), "");
+static_assert(test_loop_acceleration({word{AXA, 2, 0, INC}, word{JA, 0, 0, NEGATIVE}}, -201, 0, 0), "");
+static_assert(test_loop_acceleration({word{AXA, 2, 0, INC}, word{JA, 0, 0, NONPOSITIVE}}, -200, 0, 0), "");
+static_assert(test_loop_acceleration({word{AXX, 4, 0, INC}, word{JX, 0, 0, NONZERO}}, 0, 0, -400), "");
+static_assert(test_loop_acceleration({word{AXX, 4, 0, DEC}, word{JX, 0, 0, ZERO}}, 0, 0, 4), "");
+
+// Several registers, and a counter that moves back and forth within an iteration
+static_assert(test_loop_acceleration({
+    word{AX2, 3, 0, INC},
+    word{AX1, 5, 0, DEC},
+    word{AXA, 7, 0, DEC},
+    word{AX1, 3, 0, INC},
+    word{AX6, 0, 0, INC},
+    word{J1, 0, 0, POSITIVE}}, 10, 251, 0), "");
+
+// Loops that wrap a register past 30 bits, at the end of an iteration or within one, run as usual
+static_assert(test_loop_acceleration({word{AX1, 1, 0, DEC}, word{AXA, 1, 0, INC}, word{J1, 0, 0, POSITIVE}}, 1073741800, 100, 0), "");
+static_assert(test_loop_acceleration({
+    word{AXA, 1000, 0, INC},
+    word{AXA, 1000, 0, DEC},
+    word{AX1, 1, 0, DEC},
+    word{J1, 0, 0, POSITIVE}}, 1073741000, 100, 0), "");
+
+// Loops that aren't counted
+static_assert(test_loop_acceleration({word{AX1, 1, 0, DEC}, word{AXA, 1, 0, ENT}, word{J1, 0, 0, POSITIVE}}, 0, 100, 0), "");
+static_assert(test_loop_acceleration({word{AX1, 1, 0, DEC}, word{AXA, 1, 1, INC}, word{J1, 0, 0, POSITIVE}}, 0, 100, 0), "");
+static_assert(test_loop_acceleration({word{AX1, 1, 0, DEC}, word{STZ, 1000, 1}, word{J1, 0, 0, POSITIVE}}, 0, 100, 0), "");
+
 constexpr auto test_comparison(word reg, word mem, field_spec f)
 {
     machine m;
@@ -212,11 +337,7 @@ constexpr auto find_max(const std::initializer_list<int>& elements)
 
     // Store the elements to memory locations X+1 ... X+n
     constexpr auto X = 1000;
-    auto i = 1;
-    for (auto e : elements)
-    {
-        m.memory[X + i++] = word{e};
-    }
+    import_words(elements.begin(), elements.size(), m.memory + X + 1);
 
     // Registers:
     // rA: max element (m)
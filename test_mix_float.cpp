@@ -0,0 +1,541 @@
+#include "ccmix/machine.hpp"
+#include "ccmix/mix_float.hpp"
+
+namespace ccmix {
+
+// Reference implementation of Knuth's algorithms A, M and N, working on base 64 digits one at a time
+
+struct ref_number
+{
+    bool neg = false;
+    int e = 0;
+    int carry = 0;
+    int d[24] = {};
+    bool sticky = false;
+};
+
+constexpr ref_number ref_unpack(word w)
+{
+    ref_number n;
+    n.neg = w.negative();
+    n.e = mix_float::exponent(w);
+    for (int i = 0; i < 4; ++i)
+    {
+        n.d[i] = (mix_float::fraction(w) >> (6 * (3 - i))) & 63;
+    }
+    return n;
+}
+
+constexpr word ref_normalize(ref_number n)
+{
+    // N4: f >= 1
+    if (n.carry != 0)
+    {
+        n.sticky = n.sticky || n.d[23] != 0;
+        for (int i = 23; i > 0; --i)
+        {
+            n.d[i] = n.d[i - 1];
+        }
+        n.d[0] = n.carry;
+        n.carry = 0;
+        ++n.e;
+    }
+
+    // N1: f = 0
+    auto zero = !n.sticky;
+    for (int i = 0; i < 24; ++i)
+    {
+        zero = zero && n.d[i] == 0;
+    }
+    if (zero)
+    {
+        return word{0, n.neg};
+    }
+
+    // N3: f < 1/b
+    while (n.d[0] == 0)
+    {
+        for (int i = 0; i < 23; ++i)
+        {
+            n.d[i] = n.d[i + 1];
+        }
+        n.d[23] = 0;
+        --n.e;
+    }
+
+    // N5
+    auto beyond_half = n.sticky;
+    for (int i = 5; i < 24; ++i)
+    {
+        beyond_half = beyond_half || n.d[i] != 0;
+    }
+    const auto up = n.d[4] > 32 || (n.d[4] == 32 && (beyond_half || n.d[3] % 2 == 0));
+
+    if (up)
+    {
+        auto i = 3;
+        for (; i >= 0 && n.d[i] == 63; --i)
+        {
+            n.d[i] = 0;
+        }
+
+        if (i >= 0)
+        {
+            ++n.d[i];
+        }
+        else
+        {
+            // N6: rounding overflowed to 1
+            n.d[0] = 1;
+            ++n.e;
+        }
+    }
+
+    unsigned int f = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+        f = f << 6 | n.d[i];
+    }
+    return word{static_cast<unsigned int>(n.e & 63) << 24 | f, n.neg};
+}
+
+constexpr word ref_add(word wu, word wv)
+{
+    auto u = ref_unpack(wu);
+    auto v = ref_unpack(wv);
+
+    if (u.e < v.e)
+    {
+        const auto t = u;
+        u = v;
+        v = t;
+    }
+
+    const auto d = u.e - v.e;
+    if (d >= 6)
+    {
+        return ref_normalize(u);
+    }
+
+    for (int i = 23; i >= 0; --i)
+    {
+        v.d[i] = i >= d ? v.d[i - d] : 0;
+    }
+
+    ref_number w;
+    w.e = u.e;
+
+    if (u.neg == v.neg)
+    {
+        w.neg = u.neg;
+        auto carry = 0;
+        for (int i = 23; i >= 0; --i)
+        {
+            const auto s = u.d[i] + v.d[i] + carry;
+            w.d[i] = s % 64;
+            carry = s / 64;
+        }
+        w.carry = carry;
+        return ref_normalize(w);
+    }
+
+    auto cmp = 0;
+    for (int i = 0; i < 24 && cmp == 0; ++i)
+    {
+        cmp = u.d[i] < v.d[i] ? -1 : u.d[i] > v.d[i] ? 1 : 0;
+    }
+
+    const auto& big = cmp < 0 ? v : u;
+    const auto& small = cmp < 0 ? u : v;
+    w.neg = cmp == 0 ? u.neg : big.neg;
+
+    auto borrow = 0;
+    for (int i = 23; i >= 0; --i)
+    {
+        auto s = big.d[i] - small.d[i] - borrow;
+        borrow = s < 0 ? 1 : 0;
+        w.d[i] = s + 64 * borrow;
+    }
+    return ref_normalize(w);
+}
+
+constexpr word ref_mul(word wu, word wv)
+{
+    const auto u = ref_unpack(wu);
+    const auto v = ref_unpack(wv);
+
+    int prod[24] = {};
+    for (int i = 0; i < 4; ++i)
+    {
+        for (int j = 0; j < 4; ++j)
+        {
+            prod[i + j + 1] += u.d[i] * v.d[j];
+        }
+    }
+
+    ref_number w;
+    w.neg = u.neg != v.neg;
+    w.e = u.e + v.e - mix_float::EXCESS;
+    auto carry = 0;
+    for (int i = 23; i >= 0; --i)
+    {
+        const auto s = prod[i] + carry;
+        w.d[i] = s % 64;
+        carry = s / 64;
+    }
+    return ref_normalize(w);
+}
+
+// Long division, for normalized operands only
+constexpr word ref_div(word wu, word wv)
+{
+    const auto u = ref_unpack(wu);
+    const auto fv = mix_float::fraction(wv);
+
+    int dividend[23] = {u.d[0], u.d[1], u.d[2], u.d[3]};
+    int quotient[23] = {};
+    unsigned int rem = 0;
+    for (int i = 0; i < 23; ++i)
+    {
+        rem = rem * 64 + dividend[i];
+        quotient[i] = static_cast<int>(rem / fv);
+        rem %= fv;
+    }
+
+    ref_number w;
+    w.neg = u.neg != wv.negative();
+    w.e = u.e - mix_float::exponent(wv) + mix_float::EXCESS + 1;
+    for (int i = 0; i < 20; ++i)
+    {
+        w.d[i] = quotient[3 + i];
+    }
+    w.sticky = rem != 0;
+    return ref_normalize(w);
+}
+
+constexpr word ref_from_int(word i)
+{
+    ref_number n;
+    n.neg = i.negative();
+    n.e = mix_float::EXCESS + 5;
+    for (int k = 0; k < 5; ++k)
+    {
+        n.d[k] = (i.abs_value() >> (6 * (4 - k))) & 63;
+    }
+    return ref_normalize(n);
+}
+
+constexpr int ref_fraction_digit(const ref_number& n, int i)
+{
+    return i >= 0 && i < 4 ? n.d[i] : 0;
+}
+
+// FIX: the digits before the radix point, rounded like step N5, truncated to five digits
+constexpr word ref_to_int(word w)
+{
+    const auto u = ref_unpack(w);
+    const auto n_int = u.e - mix_float::EXCESS;
+
+    std::uint64_t q = 0;
+    for (int i = 0; i < n_int; ++i)
+    {
+        q = (q * 64 + ref_fraction_digit(u, i)) % (std::uint64_t{1} << 30);
+    }
+
+    const auto first = ref_fraction_digit(u, n_int);
+    auto rest = false;
+    for (int i = n_int + 1; i < 4; ++i)
+    {
+        rest = rest || ref_fraction_digit(u, i) != 0;
+    }
+    const auto up = first > 32 || (first == 32 && (rest || q % 2 == 0));
+
+    return word{static_cast<unsigned int>(up ? q + 1 : q), u.neg};
+}
+
+// The base 64 digit of a floating point magnitude that has the weight 64^position
+constexpr int ref_digit_at(int e, unsigned int f, int position)
+{
+    const auto i = e - mix_float::EXCESS - 1 - position;
+    return i >= 0 && i < 4 ? static_cast<int>(f >> (6 * (3 - i))) & 63 : 0;
+}
+
+// FCMP: the rounded difference compared digit by digit with epsilon * 64^(max(eu, ev) - q)
+constexpr int ref_compare(word u, word v, word epsilon)
+{
+    const auto w = ref_add(v, word{u.abs_value(), !u.negative()});
+    const auto fw = mix_float::fraction(w);
+    if (fw == 0)
+    {
+        return 0;
+    }
+
+    const auto e = mix_float::exponent(u) > mix_float::exponent(v) ? mix_float::exponent(u) : mix_float::exponent(v);
+    const auto te = mix_float::exponent(epsilon) + e - mix_float::EXCESS;
+    const auto fe = mix_float::fraction(epsilon);
+
+    // From the leading digit of the larger exponent down to the last digit of the smaller one
+    const auto ew = mix_float::exponent(w);
+    const auto top = (ew > te ? ew : te) - mix_float::EXCESS - 1;
+    const auto bottom = (ew < te ? ew : te) - mix_float::EXCESS - 4;
+
+    auto cmp = 0;
+    for (int position = top; position >= bottom && cmp == 0; --position)
+    {
+        const auto dw = ref_digit_at(ew, fw, position);
+        const auto de = ref_digit_at(te, fe, position);
+        cmp = dw < de ? -1 : dw > de ? 1 : 0;
+    }
+
+    if (cmp <= 0)
+    {
+        return 0;
+    }
+
+    return w.negative() ? 1 : -1;
+}
+
+// Pseudo-random floating point numbers with exponents close to each other
+
+struct lcg
+{
+    std::uint64_t state;
+
+    constexpr unsigned int next()
+    {
+        state = state * 6364136223846793005u + 1442695040888963407u;
+        return static_cast<unsigned int>(state >> 33);
+    }
+
+    constexpr word next_float()
+    {
+        const auto r = next();
+        const auto e = static_cast<unsigned int>(mix_float::EXCESS - 8 + r % 17);
+        const auto patterns = next();
+        // Mostly random fractions, but also ones full of zero and 63 digits to hit carries and ties
+        auto f = (next() & 0xFFFFFF) | (1u << 18);
+        if (patterns % 4 == 0)
+        {
+            f &= 0xFC003F | (1u << 18);
+        }
+        else if (patterns % 4 == 1)
+        {
+            f |= 0x03FFC0;
+        }
+        return word{e << 24 | f, (r & 0x100000) != 0};
+    }
+};
+
+template <class F, class Ref>
+constexpr bool check_random(F op, Ref ref, std::uint64_t seed, int n)
+{
+    lcg rng{seed};
+    for (int i = 0; i < n; ++i)
+    {
+        const auto u = rng.next_float();
+        const auto v = rng.next_float();
+        const auto a = op(u, v);
+        const auto b = ref(u, v);
+        if (a.abs_value() != b.abs_value() || a.negative() != b.negative())
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// All combinations of edge case fractions, signs and exponent differences
+template <class F, class Ref>
+constexpr bool check_exhaustive(F op, Ref ref)
+{
+    constexpr unsigned int fractions[] = {0x040000, 0x040001, 0x07FFFF, 0x800000, 0x800020, 0xFFFFC0, 0xFFFFFF, 0x123456};
+
+    for (auto fu : fractions)
+    {
+        for (auto fv : fractions)
+        {
+            for (unsigned int d = 0; d < 8; ++d)
+            {
+                for (int signs = 0; signs < 4; ++signs)
+                {
+                    const word u{(mix_float::EXCESS + d) << 24 | fu, (signs & 1) != 0};
+                    const word v{static_cast<unsigned int>(mix_float::EXCESS) << 24 | fv, (signs & 2) != 0};
+                    const auto a = op(u, v);
+                    const auto b = ref(u, v);
+                    const auto a2 = op(v, u);
+                    const auto b2 = ref(v, u);
+                    if (a.abs_value() != b.abs_value() || a.negative() != b.negative()
+                        || a2.abs_value() != b2.abs_value() || a2.negative() != b2.negative())
+                    {
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+    return true;
+}
+
+struct fast_add { constexpr word operator()(word u, word v) const { return mix_float::add(u, v); } };
+struct fast_mul { constexpr word operator()(word u, word v) const { return mix_float::mul(u, v); } };
+struct fast_div { constexpr word operator()(word u, word v) const { return mix_float::div(u, v); } };
+struct reference_add { constexpr word operator()(word u, word v) const { return ref_add(u, v); } };
+struct reference_mul { constexpr word operator()(word u, word v) const { return ref_mul(u, v); } };
+struct reference_div { constexpr word operator()(word u, word v) const { return ref_div(u, v); } };
+
+static_assert(check_exhaustive(fast_add{}, reference_add{}), "");
+static_assert(check_exhaustive(fast_mul{}, reference_mul{}), "");
+static_assert(check_exhaustive(fast_div{}, reference_div{}), "");
+static_assert(check_random(fast_add{}, reference_add{}, 1, 1000), "");
+static_assert(check_random(fast_mul{}, reference_mul{}, 2, 1000), "");
+static_assert(check_random(fast_div{}, reference_div{}, 3, 1000), "");
+
+// FIX and FCMP in the same checks, FIX ignoring v and FCMP returning its result in a word
+struct fast_to_int { constexpr word operator()(word u, word) const { return mix_float::to_int(u); } };
+struct reference_to_int { constexpr word operator()(word u, word) const { return ref_to_int(u); } };
+
+// Operands are scaled by 64^scale, to reach the exponents where epsilon's scaled exponent is near 0 or 63
+constexpr word scale_exponent(word w, int scale)
+{
+    return word{static_cast<unsigned int>((mix_float::exponent(w) + scale) & 63) << 24 | mix_float::fraction(w), w.negative()};
+}
+
+struct fast_compare
+{
+    word epsilon;
+    int scale;
+
+    constexpr word operator()(word u, word v) const
+    {
+        return word{mix_float::compare(scale_exponent(u, scale), scale_exponent(v, scale), epsilon)};
+    }
+};
+
+struct reference_compare
+{
+    word epsilon;
+    int scale;
+
+    constexpr word operator()(word u, word v) const
+    {
+        return word{ref_compare(scale_exponent(u, scale), scale_exponent(v, scale), epsilon)};
+    }
+};
+
+static_assert(check_exhaustive(fast_to_int{}, reference_to_int{}), "");
+static_assert(check_random(fast_to_int{}, reference_to_int{}, 5, 1000), "");
+
+constexpr bool check_compare(unsigned int epsilon_exponent, unsigned int epsilon_fraction, int scale, std::uint64_t seed)
+{
+    const word epsilon{epsilon_exponent << 24 | epsilon_fraction, false};
+    return check_exhaustive(fast_compare{epsilon, scale}, reference_compare{epsilon, scale})
+        && check_random(fast_compare{epsilon, scale}, reference_compare{epsilon, scale}, seed, 200);
+}
+
+// Epsilons with small, large and tiny exponents relative to the operands. 29, 0x800000 is exactly the
+// difference of 0x800000 and 0x800020 with the same exponent.
+static_assert(check_compare(29, 0x040000, 0, 6), "");
+static_assert(check_compare(29, 0x800000, 0, 7), "");
+static_assert(check_compare(30, 0xFFFFFF, 0, 8), "");
+static_assert(check_compare(2, 0x040000, 0, 9), "");
+static_assert(check_compare(60, 0x123456, 0, 10), "");
+
+// Scaled exponents of epsilon around 0 and around 63
+static_assert(check_compare(29, 0x800000, -30, 11), "");
+static_assert(check_compare(31, 0xFFFFFF, -30, 12), "");
+static_assert(check_compare(33, 0x800000, 24, 13), "");
+static_assert(check_compare(40, 0x040000, 24, 14), "");
+
+// Operands with exponent 62 whose difference carries into exponent 63, where epsilon's is 63 too
+static_assert(check_compare(33, 0x040000, 30, 15), "");
+
+// Every exponent, so that FIX also truncates integers that don't fit and rounds fractions below 1/64
+constexpr bool check_to_int_exponents()
+{
+    constexpr unsigned int fractions[] = {0x040000, 0x040020, 0x060000, 0x7E0000, 0x800000, 0x800020, 0x820000, 0xFFFFFF, 0x123456};
+
+    for (unsigned int e = 0; e < 64; ++e)
+    {
+        for (auto f : fractions)
+        {
+            for (int neg = 0; neg < 2; ++neg)
+            {
+                const word w{e << 24 | f, neg != 0};
+                const auto a = mix_float::to_int(w);
+                const auto b = ref_to_int(w);
+                if (a.abs_value() != b.abs_value() || a.negative() != b.negative())
+                {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+static_assert(check_to_int_exponents(), "");
+
+constexpr bool check_from_int()
+{
+    lcg rng{4};
+    for (int i = 0; i < 1000; ++i)
+    {
+        const auto n = rng.next();
+        const word w{n >> (n % 30), (n & 1) != 0};
+        const auto a = mix_float::from_int(w);
+        const auto b = ref_from_int(w);
+        if (a.abs_value() != b.abs_value() || a.negative() != b.negative())
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(check_from_int(), "");
+
+constexpr word make_float(unsigned int e, unsigned int f, bool neg = false)
+{
+    return word{(mix_float::EXCESS + e) << 24 | f, neg};
+}
+
+// 1 + 1 = 2, 1 / 3 = 0.(21)(21)...
+static_assert(mix_float::add(make_float(1, 0x040000), make_float(1, 0x040000)).value() == make_float(1, 0x080000).value(), "");
+static_assert(mix_float::div(make_float(1, 0x040000), make_float(1, 0xC0000)).value() == make_float(0, 0x555555).value(), "");
+
+// A tie is rounded to the odd neighbour: 0.(1)(0)(0)(0)(32) -> 0.(1)(0)(0)(1)
+static_assert(mix_float::add(make_float(1, 0x040000), make_float(0, 0x000020)).value() == make_float(1, 0x040001).value(), "");
+
+static_assert(mix_float::from_int(word{1}).value() == make_float(1, 0x040000).value(), "");
+static_assert(mix_float::from_int(word{-1'073'741'823}).value() == make_float(6, 0x040000, true).value(), "");
+static_assert(mix_float::to_int(make_float(2, 0x0C0400)).value() == 192, "");
+static_assert(mix_float::to_int(make_float(2, 0x0C0800)).value() == 193, "");
+static_assert(mix_float::to_int(make_float(2, 0x0C0820, true)).value() == -193, "");
+static_assert(mix_float::to_int(make_float(0, 0x800000)).value() == 1, "");
+
+static_assert(mix_float::compare(make_float(1, 0x040000), make_float(1, 0x040001), make_float(-3, 0x040000)) == 0, "");
+static_assert(mix_float::compare(make_float(1, 0x040000), make_float(1, 0x040002), make_float(-4, 0x040000)) < 0, "");
+static_assert(mix_float::compare(make_float(1, 0x040002), make_float(1, 0x040000), make_float(-4, 0x040000)) > 0, "");
+
+constexpr auto test_float_program(int a, int b)
+{
+    machine m;
+    m.reg_a = word{a};
+    m.memory[0] = word{SPECIAL, 0, 0, FLOT};
+    m.memory[1] = word{STA, 1000};
+    m.memory[2] = word{AXA, b, 0, ENT};
+    m.memory[3] = word{SPECIAL, 0, 0, FLOT};
+    m.memory[4] = word{DIV, 1000, 0, FLOAT}; // b / a
+    m.memory[5] = word{MUL, 1000, 0, FLOAT};
+    m.memory[6] = word{SUB, 1000, 0, FLOAT};
+    m.memory[7] = word{ADD, 1000, 0, FLOAT};
+    m.memory[8] = word{SPECIAL, 0, 0, FIX};
+    m.memory[9] = word{SPECIAL, 0, 0, HLT};
+    m.run();
+    return m.reg_a.value();
+}
+
+static_assert(test_float_program(3, 12) == 12, "");
+static_assert(test_float_program(-7, 1000) == 1000, "");
+
+}
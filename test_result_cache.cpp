@@ -0,0 +1,62 @@
+#include "ccmix/result_cache.hpp"
+
+namespace ccmix {
+
+constexpr auto template_machine()
+{
+    machine m;
+    m.memory[0] = word{LDA, 1000};
+    m.memory[1] = word{ADD, 1001};
+    m.memory[2] = word{SPECIAL, 0, 0, HLT};
+    m.memory[1000] = word{5};
+    m.reg_i[0] = word{3};
+    return m;
+}
+
+// The incrementally updated key equals the key computed from scratch
+constexpr auto test_incremental_key()
+{
+    tracked_machine job{template_machine()};
+    job.key();
+    job.write(1000, word{7});
+    job.write(1001, word{-8});
+    job.write(1000, word{9});
+    job.cpu().reg_x = word{4};
+    const auto key = job.key();
+
+    auto m = template_machine();
+    m.memory[1000] = word{9};
+    m.memory[1001] = word{-8};
+    m.reg_x = word{4};
+    return key == tracked_machine{m}.key();
+}
+
+static_assert(test_incremental_key(), "");
+
+constexpr auto test_restored_key()
+{
+    tracked_machine job{template_machine()};
+    const auto before = job.key();
+    job.write(1000, word{6});
+    const auto changed = job.key();
+    job.write(1000, word{5});
+    return job.key() == before && !(changed == before);
+}
+
+static_assert(test_restored_key(), "");
+
+// Keys tell apart states that differ only in where values are, in the sign of zero or in the registers
+constexpr auto key_after(int addr1, word w1, int addr2, word w2, int pc)
+{
+    tracked_machine job{template_machine()};
+    job.write(addr1, w1);
+    job.write(addr2, w2);
+    job.cpu().pc = pc;
+    return job.key();
+}
+
+static_assert(!(key_after(1000, word{1}, 1001, word{2}, 0) == key_after(1000, word{2}, 1001, word{1}, 0)), "");
+static_assert(!(key_after(1000, word{0, false}, 1001, word{0}, 0) == key_after(1000, word{0, true}, 1001, word{0}, 0)), "");
+static_assert(!(key_after(1000, word{1}, 1001, word{2}, 0) == key_after(1000, word{1}, 1001, word{2}, 1)), "");
+
+}
@@ -0,0 +1,86 @@
+#include "ccmix/sandbox.hpp"
+
+namespace ccmix {
+
+constexpr std::uint64_t BUDGET = 1000;
+
+constexpr auto run_one(word instruction, int pc = 0)
+{
+    machine m;
+    m.pc = pc;
+    m.memory[pc] = instruction;
+    m.memory[pc + 1 < machine::memory_size ? pc + 1 : 0] = word{SPECIAL, 0, 0, HLT};
+    return run_sandboxed(m, BUDGET);
+}
+
+static_assert(run_one(word{LDA, 1000}) == sandbox_result::HALTED, "");
+static_assert(run_one(word{LDA, 1000, 0, field_spec{1, 5}.as_opcode_mod()}) == sandbox_result::HALTED, "");
+static_assert(run_one(word{ADD, 1000, 0, FLOAT}) == sandbox_result::HALTED, "");
+static_assert(run_one(word{SPECIAL, 3999, 0, XCH}) == sandbox_result::HALTED, "");
+
+// Instructions the interpreter can't run safely
+static_assert(run_one(word{LDA, 1000, 7}) == sandbox_result::FAULT, "");
+static_assert(run_one(word{LDA, 1000, 0, field_spec{3, 2}.as_opcode_mod()}) == sandbox_result::FAULT, "");
+static_assert(run_one(word{STA, 1000, 0, field_spec{0, 6}.as_opcode_mod()}) == sandbox_result::FAULT, "");
+static_assert(run_one(word{CMPX, 1000, 0, FLOAT}) == sandbox_result::FAULT, "");
+
+// Accesses outside memory
+static_assert(run_one(word{LDA, 4000}) == sandbox_result::FAULT, "");
+static_assert(run_one(word{STA, -1}) == sandbox_result::FAULT, "");
+static_assert(run_one(word{SPECIAL, 4000, 0, CAS}) == sandbox_result::FAULT, "");
+static_assert(run_one(word{JMP, 4000}) == sandbox_result::FAULT, "");
+static_assert(run_one(word{SPECIAL, 0, 0, HLT}, 3999) == sandbox_result::HALTED, "");
+static_assert(run_one(word{SPECIAL, 0, 0, FLOT}, 3999) == sandbox_result::FAULT, "");
+
+constexpr auto test_bad_pc(int pc)
+{
+    machine m;
+    m.pc = pc;
+    return run_sandboxed(m, BUDGET);
+}
+
+static_assert(test_bad_pc(-1) == sandbox_result::FAULT, "");
+static_assert(test_bad_pc(4000) == sandbox_result::FAULT, "");
+
+// A store outside memory is dropped, and the run stops after it
+constexpr auto test_dropped_store()
+{
+    machine m;
+    m.reg_a = word{5};
+    m.reg_i[0] = word{3000};
+    m.memory[0] = word{STA, 1000, 1};
+    m.memory[1] = word{SPECIAL, 0, 0, HLT};
+    const auto result = run_sandboxed(m, BUDGET);
+    return result == sandbox_result::FAULT && m.pc == 1;
+}
+
+static_assert(test_dropped_store(), "");
+
+// JMP *, with a budget that runs out on the fifth jump
+constexpr auto test_budget(std::uint64_t start_cycles)
+{
+    machine m;
+    m.cycles = start_cycles;
+    m.memory[0] = word{JMP, 0};
+    const auto result = run_sandboxed(m, 5);
+    return result == sandbox_result::OVER_BUDGET && m.cycles == start_cycles + 5;
+}
+
+static_assert(test_budget(0), "");
+static_assert(test_budget(~std::uint64_t{0} - 2), "");
+
+// Counted loops aren't finished at once, but still count towards the budget
+constexpr auto test_counted_loop_budget(std::uint64_t budget)
+{
+    machine m;
+    m.memory[0] = word{AX1, 100, 0, ENT};
+    m.memory[1] = word{AX1, 1, 0, DEC};
+    m.memory[2] = word{J1, 1, 0, POSITIVE};
+    m.memory[3] = word{SPECIAL, 0, 0, HLT};
+    return run_sandboxed(m, budget);
+}
+
+static_assert(test_counted_loop_budget(1000) == sandbox_result::HALTED, "");
+static_assert(test_counted_loop_budget(100) == sandbox_result::OVER_BUDGET, "");
+
+}